@@ -0,0 +1,85 @@
+#include "batch.hpp"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <thread>
+
+// Queries handed to a worker
+/*
+	Each worker starts with its own contiguous slice of the queries.
+	Taking a query is an atomic increment of [next], which lets a worker
+		that runs out steal from the slice of another without any locks.
+*/
+struct Slice
+{
+	std::atomic<size_t> next {0};
+	size_t end = 0;
+
+	// Claim one query; returns false when there is nothing left
+	bool take(size_t& i)
+	{
+		if (next.load(std::memory_order_relaxed) >= end)
+			return false;
+		i = next.fetch_add(1, std::memory_order_relaxed);
+		return i < end;
+	}
+};
+
+std::vector<QueryResult> solve_batch(const Maze& maze, const std::vector<Query>& queries, unsigned threads,
+	OpenList list, TieBreak tie)
+{
+	std::vector<QueryResult> results(queries.size());
+	if (queries.empty())
+		return results;
+
+	if (threads == 0)
+		threads = std::max(1u, std::thread::hardware_concurrency());
+	if (threads > queries.size())
+		threads = unsigned(queries.size());
+
+	// Split the queries evenly
+	std::unique_ptr<Slice[]> slices {new Slice[threads]};
+	for (unsigned t = 0; t < threads; t++)
+	{
+		slices[t].next = queries.size() * t / threads;
+		slices[t].end = queries.size() * (t + 1) / threads;
+	}
+
+	// The maze isn't changed while solving, so every worker can read it freely
+	auto worker = [&](unsigned id)
+	{
+		// Scratch space reused for every query this worker solves
+		SearchContext search {maze, {}, {}, DFS};
+		search.set_open_list(list, tie);
+
+		// Own slice first, then go round the others
+		for (unsigned k = 0; k < threads; k++)
+		{
+			Slice& slice = slices[(id + k) % threads];
+			size_t i;
+			while (slice.take(i))
+			{
+				const Query& q = queries[i];
+				auto t0 = std::chrono::steady_clock::now();
+
+				search.reset(q.start, q.end, q.alg);
+				results[i].result = search.run();
+
+				results[i].ms = std::chrono::duration<double, std::milli>(
+					std::chrono::steady_clock::now() - t0).count();
+			}
+		}
+	};
+
+	std::vector<std::thread> pool {};
+	for (unsigned t = 1; t < threads; t++)
+		pool.emplace_back(worker, t);
+	// This thread works too
+	worker(0);
+
+	for (std::thread& t : pool)
+		t.join();
+
+	return results;
+}
@@ -0,0 +1,25 @@
+#ifndef BATCH_H_
+#define BATCH_H_
+
+#include "solver.hpp"
+#include <vector>
+
+// One path query against a maze
+struct Query
+{
+	Pos start, end;
+	int alg;
+};
+
+struct QueryResult
+{
+	SearchResult result {};
+	double ms = 0; // Time spent solving this query
+};
+
+// Solve every query on a pool of [threads] workers (0 means one per core)
+// Results are in the same order as [queries]; A* uses [list] and [tie] like solve() does
+std::vector<QueryResult> solve_batch(const Maze&, const std::vector<Query>&, unsigned threads = 0,
+	OpenList list = OpenList::BUCKET, TieBreak tie = TieBreak::LARGER_G);
+
+#endif
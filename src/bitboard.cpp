@@ -0,0 +1,303 @@
+#include "bitboard.hpp"
+#include <algorithm>
+#include <chrono>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+// The few operations a flood needs, on as many words at once as the machine allows
+#if defined(__AVX2__)
+struct Lanes
+{
+	typedef __m256i V;
+	static constexpr size_t N = 4;
+	static const char *name() { return "avx2"; }
+
+	static V load(const std::uint64_t *p) { return _mm256_loadu_si256((const V*)p); }
+	static void store(std::uint64_t *p, V v) { _mm256_storeu_si256((V*)p, v); }
+	static V fill(std::uint64_t x) { return _mm256_set1_epi64x((long long)x); }
+	static V and_(V a, V b) { return _mm256_and_si256(a, b); }
+	static V or_(V a, V b) { return _mm256_or_si256(a, b); }
+	static V and_not(V a, V b) { return _mm256_andnot_si256(b, a); } // a & ~b
+	static V shl1(V a) { return _mm256_slli_epi64(a, 1); }
+	static V shr1(V a) { return _mm256_srli_epi64(a, 1); }
+	static V shl63(V a) { return _mm256_slli_epi64(a, 63); }
+	static V shr63(V a) { return _mm256_srli_epi64(a, 63); }
+};
+#elif defined(__SSE2__)
+struct Lanes
+{
+	typedef __m128i V;
+	static constexpr size_t N = 2;
+	static const char *name() { return "sse2"; }
+
+	static V load(const std::uint64_t *p) { return _mm_loadu_si128((const V*)p); }
+	static void store(std::uint64_t *p, V v) { _mm_storeu_si128((V*)p, v); }
+	static V fill(std::uint64_t x) { return _mm_set1_epi64x((long long)x); }
+	static V and_(V a, V b) { return _mm_and_si128(a, b); }
+	static V or_(V a, V b) { return _mm_or_si128(a, b); }
+	static V and_not(V a, V b) { return _mm_andnot_si128(b, a); }
+	static V shl1(V a) { return _mm_slli_epi64(a, 1); }
+	static V shr1(V a) { return _mm_srli_epi64(a, 1); }
+	static V shl63(V a) { return _mm_slli_epi64(a, 63); }
+	static V shr63(V a) { return _mm_srli_epi64(a, 63); }
+};
+#else
+struct Lanes
+{
+	typedef std::uint64_t V;
+	static constexpr size_t N = 1;
+	static const char *name() { return "scalar"; }
+
+	static V load(const std::uint64_t *p) { return *p; }
+	static void store(std::uint64_t *p, V v) { *p = v; }
+	static V fill(std::uint64_t x) { return x; }
+	static V and_(V a, V b) { return a & b; }
+	static V or_(V a, V b) { return a | b; }
+	static V and_not(V a, V b) { return a & ~b; }
+	static V shl1(V a) { return a << 1; }
+	static V shr1(V a) { return a >> 1; }
+	static V shl63(V a) { return a << 63; }
+	static V shr63(V a) { return a >> 63; }
+};
+#endif
+
+BitGrid::BitGrid(const Maze& maze) : col(int(maze.width())), row(int(maze.height()))
+{
+	const size_t words = (size_t(col) + 63) / 64;
+	stride = (words + Lanes::N - 1) / Lanes::N * Lanes::N + 2;
+
+	const size_t total = size_t(row + 2) * stride;
+	right.assign(total, 0);
+	down.assign(total, 0);
+	for (int y = 0; y < row; y++)
+		maze.row_passages(y, &right[at(y)], &down[at(y)]);
+
+	frontier.assign(total, 0);
+	next.assign(total, 0);
+	seen.assign(total, 0);
+	plane0.assign(total, 0);
+	plane1.assign(total, 0);
+	queued.assign(row, 0);
+	first.assign(row + 2, NO_FIRST);
+	last.assign(row + 2, NO_LAST);
+	nextFirst = first, nextLast = last;
+}
+
+void BitGrid::clear_row(int y)
+{
+	if (first[y + 1] <= last[y + 1])
+		std::fill(&frontier[at(y) + first[y + 1]], &frontier[at(y) + last[y + 1] + 1], 0);
+	first[y + 1] = NO_FIRST, last[y + 1] = NO_LAST;
+}
+
+/*
+	A box x joins the next layer if it wasn't reached yet and
+		- x - 1 is in the frontier with a passage right (frontier & right, shifted up a bit)
+		- x + 1 is in the frontier with a passage left, which is the right passage of x
+		- the box above is in the frontier with a passage down
+		- the box below is in the frontier and x has a passage down
+	Bits crossing from one word to the next come from the word before or after,
+		which is why every row has a zero word on each end.
+*/
+size_t BitGrid::expand(int y, int layer)
+{
+	typedef Lanes L;
+	const std::uint64_t *f = &frontier[at(y)], *fUp = &frontier[at(y - 1)], *fDown = &frontier[at(y + 1)];
+	const std::uint64_t *r = &right[at(y)], *dUp = &down[at(y - 1)], *d = &down[at(y)];
+	std::uint64_t *n = &next[at(y)], *s = &seen[at(y)], *p0 = &plane0[at(y)], *p1 = &plane1[at(y)];
+
+	// Layers 1, 4, 7, ... are 1 mod 3 and so on
+	const L::V mask0 = L::fill((layer % 3) & 1 ? ~std::uint64_t(0) : 0);
+	const L::V mask1 = L::fill((layer % 3) & 2 ? ~std::uint64_t(0) : 0);
+
+	// Sideways moves reach a word either side of the frontier in this row,
+	//  up and down moves stay in their word
+	const int words = int(stride - 2);
+	int from = std::min(first[y + 1] - 1, std::min(first[y], first[y + 2]));
+	int to = std::max(last[y + 1] + 1, std::max(last[y], last[y + 2]));
+	// Whole vectors (the rounded up row has room for them)
+	from = std::max(from, 0) / int(L::N) * int(L::N);
+	to = std::min(to / int(L::N) * int(L::N) + int(L::N), words);
+
+	for (int k = from; k < to; k += L::N)
+	{
+		L::V cur = L::load(f + k);
+		L::V fromLeft = L::or_(L::shl1(L::and_(cur, L::load(r + k))),
+			L::shr63(L::and_(L::load(f + k - 1), L::load(r + k - 1))));
+		L::V fromRight = L::and_(L::or_(L::shr1(cur), L::shl63(L::load(f + k + 1))), L::load(r + k));
+		L::V fromAbove = L::and_(L::load(fUp + k), L::load(dUp + k));
+		L::V fromBelow = L::and_(L::load(fDown + k), L::load(d + k));
+
+		L::V fresh = L::and_not(L::or_(L::or_(fromLeft, fromRight), L::or_(fromAbove, fromBelow)),
+			L::load(s + k));
+		L::store(n + k, fresh);
+		L::store(s + k, L::or_(L::load(s + k), fresh));
+		L::store(p0 + k, L::or_(L::load(p0 + k), L::and_(fresh, mask0)));
+		L::store(p1 + k, L::or_(L::load(p1 + k), L::and_(fresh, mask1)));
+	}
+
+	size_t count = 0;
+	int lo = NO_FIRST, hi = NO_LAST;
+	for (int k = from; k < to; k++)
+	{
+		if (n[k] != 0)
+		{
+			count += __builtin_popcountll(n[k]);
+			lo = std::min(lo, k), hi = k;
+		}
+	}
+	nextFirst[y + 1] = lo, nextLast[y + 1] = hi;
+	return count;
+}
+
+int BitGrid::flood(Pos start, Pos end)
+{
+	std::fill(seen.begin(), seen.end(), 0);
+	std::fill(plane0.begin(), plane0.end(), 0);
+	std::fill(plane1.begin(), plane1.end(), 0);
+	for (int y : active)
+		clear_row(y);
+	active.clear();
+	reachedCount = peakLayer = 0;
+	depth = 0;
+
+	if (!in_maze(start))
+		return -1;
+
+	const std::uint64_t bit = std::uint64_t(1) << (start.x & 63);
+	frontier[at(start.y) + (start.x >> 6)] = bit;
+	seen[at(start.y) + (start.x >> 6)] = bit;
+	first[start.y + 1] = last[start.y + 1] = start.x >> 6;
+	active.push_back(start.y);
+	reachedCount = peakLayer = 1;
+	if (start == end)
+		return 0;
+
+	const bool goal = in_maze(end);
+	for (int layer = 1; !active.empty(); layer++)
+	{
+		// Rows the new layer can be in
+		touched.clear();
+		for (int y : active)
+		{
+			for (int t = std::max(y - 1, 0); t <= std::min(y + 1, row - 1); t++)
+			{
+				if (!queued[t])
+					queued[t] = 1, touched.push_back(t);
+			}
+		}
+
+		size_t count = 0;
+		for (int y : touched)
+		{
+			queued[y] = 0;
+			count += expand(y, layer);
+		}
+
+		// The new layer is the frontier now; the old one's rows go back to zero
+		for (int y : active)
+			clear_row(y);
+		frontier.swap(next);
+		first.swap(nextFirst);
+		last.swap(nextLast);
+		active.clear();
+		for (int y : touched)
+		{
+			if (first[y + 1] <= last[y + 1])
+				active.push_back(y);
+		}
+
+		if (count == 0)
+			break;
+		reachedCount += count;
+		peakLayer = std::max(peakLayer, count);
+		depth = layer;
+		if (goal && test(seen, end.x, end.y))
+			return layer;
+	}
+
+	return -1;
+}
+
+bool BitGrid::reached(const Pos& p) const
+{
+	return in_maze(p) && test(seen, p.x, p.y);
+}
+
+std::vector<Pos> BitGrid::path(Pos end) const
+{
+	std::vector<Pos> boxes {};
+	if (!reached(end))
+		return boxes;
+
+	// Step to whichever open neighbour is one closer, until the start (which has no such neighbour)
+	Pos curr = end;
+	boxes.push_back(curr);
+	while (true)
+	{
+		const int x = curr.x, y = curr.y;
+		const int want = (mod3(x, y) + 2) % 3;
+		const Pos neighbours[]
+		{
+			{x, y - 1}, {x, y + 1}, {x - 1, y}, {x + 1, y}
+		};
+		const bool open[]
+		{
+			y > 0 && test(down, x, y - 1),
+			test(down, x, y),
+			x > 0 && test(right, x - 1, y),
+			test(right, x, y)
+		};
+
+		bool moved = false;
+		for (int i = 0; i < 4 && !moved; i++)
+		{
+			const Pos& p = neighbours[i];
+			if (open[i] && test(seen, p.x, p.y) && mod3(p.x, p.y) == want)
+				curr = p, moved = true;
+		}
+		if (!moved || boxes.size() > reachedCount)
+			break;
+		boxes.push_back(curr);
+	}
+
+	std::reverse(boxes.begin(), boxes.end());
+	return boxes;
+}
+
+SearchResult BitGrid::solve(Pos start, Pos end)
+{
+	SearchResult res {};
+	auto t0 = std::chrono::steady_clock::now();
+
+	int steps = flood(start, end);
+	if (steps >= 0)
+	{
+		res.path = path(end);
+		res.found = true;
+		res.pathLength = res.path.size();
+	}
+
+	res.expanded = res.stats.pushed = reachedCount;
+	res.stats.peakFrontier = peakLayer;
+	res.stats.peakBytes = bytes();
+	res.stats.ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+		std::chrono::steady_clock::now() - t0).count();
+	return res;
+}
+
+size_t BitGrid::bytes() const
+{
+	return (right.capacity() + down.capacity() + frontier.capacity() + next.capacity()
+		+ seen.capacity() + plane0.capacity() + plane1.capacity()) * sizeof(std::uint64_t)
+		+ (active.capacity() + touched.capacity()) * sizeof(int) + queued.capacity();
+}
+
+const char *BitGrid::simd()
+{
+	return Lanes::name();
+}
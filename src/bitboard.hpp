@@ -0,0 +1,93 @@
+#ifndef BITBOARD_H_
+#define BITBOARD_H_
+
+#include "maze.hpp"
+#include "solver.hpp"
+#include <cstdint>
+#include <vector>
+
+// Breadth-first search on bitboards
+/*
+	Every row of the maze is a row of bits, 64 boxes to a word.
+	Built once per maze: which boxes have an open passage to the right and down.
+
+	A flood keeps the frontier (the boxes exactly d steps from the start) as bits too,
+		and gets the next layer for a whole word at a time:
+		- shifted left and right one bit, masked by the right passages
+		- taken from the rows above and below, masked by the down passages
+		- minus everything reached before
+	Only rows next to a frontier row are looked at, and only the words of them
+		near frontier words, so a narrow or diagonal frontier stays cheap.
+
+	Words are handled 4 at a time with AVX2, or 2 with SSE2, when the compiler has them
+		(SSE2 is always there on x86-64; AVX2 needs -mavx2 or -march=native),
+		and one at a time otherwise.
+
+	Distances are only kept modulo 3 (two bit planes): neighbours are never more than
+		a step apart, so that's enough to tell which neighbour is one step closer
+		when walking back from the end.
+*/
+class BitGrid
+{
+private:
+	int col = 0, row = 0;
+	// 64-bit words per row: the maze's words, rounded up to whole vectors,
+	//  plus a zero word on either side so shifts never go out of the row
+	size_t stride = 0;
+
+	// (row + 2) rows each, with a zero row above and below the maze
+	std::vector<std::uint64_t> right {}, down {}; // Passages (built once)
+	std::vector<std::uint64_t> frontier {}, next {}, seen {}, plane0 {}, plane1 {}; // Flood state
+
+	// Rows the frontier is in, rows next to them, and whether a row is in [touched] already
+	std::vector<int> active {}, touched {};
+	std::vector<unsigned char> queued {};
+	// First and last word of each row (from -1 to [row]) with frontier bits in it,
+	//  so a row only goes through the words near the frontier
+	// Rows without any are NO_FIRST and NO_LAST, far enough apart that min and max still work
+	enum : int { NO_FIRST = 1 << 29, NO_LAST = -(1 << 29) };
+	std::vector<int> first {}, last {}, nextFirst {}, nextLast {};
+
+	size_t reachedCount = 0, peakLayer = 0;
+	int depth = 0;
+
+	// First word of row [y] (y can be -1 or [row], the zero rows)
+	size_t at(int y) const { return size_t(y + 1) * stride + 1; }
+	bool test(const std::vector<std::uint64_t>& bits, int x, int y) const
+		{ return (bits[at(y) + (x >> 6)] >> (x & 63)) & 1; }
+	// Distance of a reached box, modulo 3
+	int mod3(int x, int y) const { return test(plane0, x, y) | (test(plane1, x, y) << 1); }
+	bool in_maze(const Pos& p) const { return p.x >= 0 && p.y >= 0 && p.x < col && p.y < row; }
+
+	// Next layer of row [y] into [next] (and [seen] and the planes); returns how many boxes it got
+	size_t expand(int y, int layer);
+	// Zero the frontier words of row [y]
+	void clear_row(int y);
+
+public:
+	BitGrid() = default;
+	explicit BitGrid(const Maze&);
+
+	// Flood from [start] until [end] is reached, or over everything reachable
+	//  when [end] is outside the maze
+	// Returns the number of steps from [start] to [end] (-1 if not reached)
+	int flood(Pos start, Pos end = {-1, -1});
+
+	// About the last flood()
+	bool reached(const Pos&) const;
+	size_t num_reached() const { return reachedCount; }
+	// Steps to the farthest box reached
+	int layers() const { return depth; }
+	// Boxes from the start to [end] (empty if [end] wasn't reached)
+	std::vector<Pos> path(Pos end) const;
+
+	// flood() and path() as a SearchResult, like the other searches
+	//  (every box reached counts as expanded)
+	SearchResult solve(Pos start, Pos end);
+
+	size_t bytes() const;
+	// Which instructions the flood was built with ("avx2", "sse2" or "scalar")
+	static const char *simd();
+};
+
+#endif
@@ -0,0 +1,279 @@
+#include "draw.hpp"
+#include "solver.hpp"
+#include "raylib.h"
+#include <algorithm>
+#include <utility>
+#include <vector>
+
+static Color MINT = (Color) {99, 163, 117, 255};
+// Light green
+static Color PATH_GREEN = (Color) {122, 229, 130, 255};
+// The search from the end of a bidirectional search
+static Color BACK_MINT = (Color) {99, 140, 163, 255};
+static Color BACK_FRONTIER = (Color) {180, 200, 230, 255};
+
+// Biggest texture made (GPUs go at least this far)
+static constexpr int MAX_TEXTURE = 4096;
+// Below this many pixels per box on screen, walls are drawn as [density] instead of lines
+static constexpr float MIN_BOX_PIXELS = 4;
+
+// Walls of the maze, drawn once (only if the maze fits)
+static RenderTexture2D walls {};
+// How many walls there are per block of boxes, for when the maze is too big and far away
+static Texture2D density {};
+// Maze::version() that [walls] or [density] was last made from (0: neither yet)
+static std::uint64_t drawnVersion = 0;
+// One pixel per box of the search, in tiles of at most [MAX_TEXTURE] boxes a side
+struct BoxTile
+{
+	Texture2D texture {};
+	std::vector<Color> colours {}; // Copy of [texture] in memory
+	int x0 = 0, y0 = 0, cols = 0, rows = 0; // Boxes it covers
+	int top = 0, bottom = -1; // Rows changed this frame
+};
+static std::vector<BoxTile> boxTiles {};
+static int boxCols = 0, boxRows = 0, tilesAcross = 0;
+// Reused every frame for the boxes that changed
+static std::vector<Pos> changed {};
+
+void unload_drawing()
+{
+	if (walls.id != 0)
+		UnloadRenderTexture(walls);
+	if (density.id != 0)
+		UnloadTexture(density);
+	for (BoxTile& tile : boxTiles)
+		UnloadTexture(tile.texture);
+	boxTiles.clear();
+	walls = RenderTexture2D {};
+	density = Texture2D {};
+}
+
+// Use DrawLines to connect vertices (an edge)
+// Only vertices [x0, x1] x [y0, y1] are drawn
+static void draw_walls(const Maze& maze, int blockSize, int x0, int y0, int x1, int y1)
+{
+	for (int i = y0; i <= y1; i++)
+	{
+		for (int j = x0; j <= x1; j++)
+		{
+			// i represents the current row
+			// j represents the current column
+			// Only the right and bottom edge of each vertex, so every wall is drawn once
+			Vector2 start = {float(j) * blockSize, float(i) * blockSize};
+			if (maze.is_wall({j, i}, {j + 1, i}))
+				DrawLineV(start, {start.x + blockSize, start.y}, WHITE);
+			if (maze.is_wall({j, i}, {j, i + 1}))
+				DrawLineV(start, {start.x, start.y + blockSize}, WHITE);
+		}
+	}
+}
+
+// Each pixel is a block of [scale] x [scale] boxes, brighter the more walls it has
+static void make_density(const Maze& maze, int scale)
+{
+	const int col = int(maze.width()), row = int(maze.height());
+	const int w = (col + scale - 1) / scale, h = (row + scale - 1) / scale;
+	std::vector<int> count(size_t(w) * h, 0);
+	for (int y = 0; y < row; y++)
+	{
+		for (int x = 0; x < col; x++)
+		{
+			// A box has at most 2 walls of its own (top and left), so counts are out of 2 * scale^2
+			int walls = maze.is_wall({x, y}, {x + 1, y}) + maze.is_wall({x, y}, {x, y + 1});
+			count[(y / scale) * w + x / scale] += walls;
+		}
+	}
+
+	std::vector<Color> pixels(count.size());
+	for (size_t i = 0; i < count.size(); i++)
+	{
+		unsigned char level = (unsigned char)std::min(255, count[i] * 255 / (scale * scale * 2));
+		pixels[i] = {255, 255, 255, level};
+	}
+
+	Image image {};
+	image.data = pixels.data();
+	image.width = w, image.height = h;
+	image.mipmaps = 1;
+	image.format = PIXELFORMAT_UNCOMPRESSED_R8G8B8A8;
+	if (density.id != 0)
+		UnloadTexture(density);
+	density = LoadTextureFromImage(image);
+	SetTextureFilter(density, TEXTURE_FILTER_BILINEAR);
+}
+
+void draw_maze(const Maze& maze, int blockSize, const Camera2D& camera)
+{
+	const int col = int(maze.width()), row = int(maze.height());
+	// One extra pixel, so the lines on the right and bottom border fit
+	int w = col * blockSize + 1, h = row * blockSize + 1;
+	const bool fits = (w <= MAX_TEXTURE && h <= MAX_TEXTURE);
+	// An edit makes a new version (and a new maze has one of its own)
+	bool wallsChanged = maze.version() != drawnVersion;
+
+	if (fits)
+	{
+		if (walls.id == 0 || walls.texture.width != w || walls.texture.height != h)
+		{
+			if (walls.id != 0)
+				UnloadRenderTexture(walls);
+			walls = LoadRenderTexture(w, h);
+			wallsChanged = true;
+		}
+
+		if (wallsChanged)
+		{
+			BeginTextureMode(walls);
+				ClearBackground(BLANK);
+				draw_walls(maze, blockSize, 0, 0, col, row);
+			EndTextureMode();
+			drawnVersion = maze.version();
+		}
+
+		// Render textures are stored upside down
+		// (the GPU skips whatever is off screen)
+		DrawTextureRec(walls.texture, {0, 0, float(w), -float(h)}, {0, 0}, WHITE);
+		return;
+	}
+
+	if (blockSize * camera.zoom >= MIN_BOX_PIXELS)
+	{
+		// Vertices inside the view (and one more around it)
+		Vector2 topLeft = GetScreenToWorld2D({0, 0}, camera);
+		Vector2 bottomRight = GetScreenToWorld2D({float(GetScreenWidth()), float(GetScreenHeight())}, camera);
+		int x0 = std::max(0, int(topLeft.x / blockSize) - 1), y0 = std::max(0, int(topLeft.y / blockSize) - 1);
+		int x1 = std::min(col, int(bottomRight.x / blockSize) + 1), y1 = std::min(row, int(bottomRight.y / blockSize) + 1);
+		if (x0 <= x1 && y0 <= y1)
+			draw_walls(maze, blockSize, x0, y0, x1, y1);
+		return;
+	}
+
+	// Far away: the whole maze at once, [scale] boxes to a pixel
+	if (density.id == 0 || wallsChanged)
+	{
+		make_density(maze, (std::max(col, row) + MAX_TEXTURE - 1) / MAX_TEXTURE);
+		drawnVersion = maze.version();
+	}
+	DrawTexturePro(density, {0, 0, float(density.width), float(density.height)},
+		{0, 0, float(col * blockSize), float(row * blockSize)}, {0, 0}, 0, WHITE);
+	DrawRectangleLines(0, 0, col * blockSize, row * blockSize, WHITE);
+}
+
+static Color box_colour(Box state)
+{
+	switch (state)
+	{
+		case Box::EXPLORED:
+			return MINT; // Explored gets green
+		case Box::PATH:
+			return PATH_GREEN;
+		case Box::BACK_EXPLORED:
+			return BACK_MINT;
+		case Box::BACK_FRONTIER:
+			return BACK_FRONTIER;
+		case Box::NONE:
+			return BLANK;
+		default:
+			return LIGHTGRAY; // Unvisited gets light gray
+	}
+}
+
+// Cut a [cols] x [rows] maze into tiles, all boxes blank
+static void make_box_tiles(int cols, int rows)
+{
+	for (BoxTile& tile : boxTiles)
+		UnloadTexture(tile.texture);
+	boxTiles.clear();
+	boxCols = cols, boxRows = rows;
+	tilesAcross = (cols + MAX_TEXTURE - 1) / MAX_TEXTURE;
+
+	for (int y0 = 0; y0 < rows; y0 += MAX_TEXTURE)
+	{
+		for (int x0 = 0; x0 < cols; x0 += MAX_TEXTURE)
+		{
+			BoxTile tile {};
+			tile.x0 = x0, tile.y0 = y0;
+			tile.cols = std::min(MAX_TEXTURE, cols - x0), tile.rows = std::min(MAX_TEXTURE, rows - y0);
+			tile.colours.assign(size_t(tile.cols) * tile.rows, BLANK);
+
+			Image image {};
+			image.data = tile.colours.data();
+			image.width = tile.cols, image.height = tile.rows;
+			image.mipmaps = 1;
+			image.format = PIXELFORMAT_UNCOMPRESSED_R8G8B8A8;
+			tile.texture = LoadTextureFromImage(image);
+			// Stretched boxes stay sharp
+			SetTextureFilter(tile.texture, TEXTURE_FILTER_POINT);
+			boxTiles.push_back(std::move(tile));
+		}
+	}
+}
+
+void draw_box(const Maze& maze, int boxSize)
+{
+	const int cols = int(maze.width()), rows = int(maze.height());
+	if (cols == 0 || rows == 0)
+		return;
+
+	if (boxTiles.empty() || cols != boxCols || rows != boxRows)
+		make_box_tiles(cols, rows);
+
+	if (!box_changes(changed))
+	{
+		// All new: start over from every box of the search
+		for (BoxTile& tile : boxTiles)
+		{
+			for (int y = 0; y < tile.rows; y++)
+				for (int x = 0; x < tile.cols; x++)
+					tile.colours[y * tile.cols + x] = box_colour(search_box({tile.x0 + x, tile.y0 + y}));
+			UpdateTexture(tile.texture, tile.colours.data());
+		}
+	}
+	else if (!changed.empty())
+	{
+		// Only upload the rows of each tile between its highest and lowest change
+		for (const Pos& p : changed)
+		{
+			if (p.x < 0 || p.y < 0 || p.x >= cols || p.y >= rows)
+				continue;
+			BoxTile& tile = boxTiles[(p.y / MAX_TEXTURE) * tilesAcross + p.x / MAX_TEXTURE];
+			const int x = p.x - tile.x0, y = p.y - tile.y0;
+			tile.colours[y * tile.cols + x] = box_colour(search_box(p));
+			if (tile.bottom < tile.top)
+				tile.top = tile.bottom = y;
+			else
+				tile.top = std::min(tile.top, y), tile.bottom = std::max(tile.bottom, y);
+		}
+		for (BoxTile& tile : boxTiles)
+		{
+			if (tile.bottom >= tile.top)
+				UpdateTextureRec(tile.texture, {0, float(tile.top), float(tile.cols), float(tile.bottom - tile.top + 1)},
+					tile.colours.data() + tile.top * tile.cols);
+			tile.top = 0, tile.bottom = -1;
+		}
+	}
+
+	// (the GPU skips the tiles that are off screen)
+	for (const BoxTile& tile : boxTiles)
+		DrawTexturePro(tile.texture, {0, 0, float(tile.cols), float(tile.rows)},
+			{float(tile.x0) * boxSize, float(tile.y0) * boxSize, float(tile.cols) * boxSize, float(tile.rows) * boxSize},
+			{0, 0}, 0, WHITE);
+}
+
+void draw_agents(const std::vector<Pos>& agents, int blockSize, const Camera2D& camera)
+{
+	// Boxes in view (one extra on each side)
+	Vector2 topLeft = GetScreenToWorld2D({0, 0}, camera);
+	Vector2 bottomRight = GetScreenToWorld2D({float(GetScreenWidth()), float(GetScreenHeight())}, camera);
+	const int x0 = int(topLeft.x / blockSize) - 1, y0 = int(topLeft.y / blockSize) - 1;
+	const int x1 = int(bottomRight.x / blockSize) + 1, y1 = int(bottomRight.y / blockSize) + 1;
+
+	for (const Pos& a : agents)
+	{
+		if (a.x < x0 || a.x > x1 || a.y < y0 || a.y > y1)
+			continue;
+		DrawCircleV({float(a.x * blockSize + blockSize / 2), float(a.y * blockSize + blockSize / 2)},
+			blockSize / 4.0f, ORANGE);
+	}
+}
@@ -0,0 +1,28 @@
+#ifndef DRAW_H_
+#define DRAW_H_
+
+#include "maze.hpp"
+#include "raylib.h"
+#include <vector>
+
+// Everything that needs raylib lives here, so the core builds without it
+/*
+	Both are drawn in world space (call between BeginMode2D and EndMode2D with [camera]),
+		where a box is [blockSize] units wide.
+	Nothing is drawn box by box each frame:
+		- the walls of a maze that fits in a texture are drawn into one once,
+			and redrawn only once its version() changes
+		- a bigger maze only draws the walls inside the view, and once boxes are
+			too small to see them (zoomed far out), a texture of how dense the walls are
+		- the boxes of the search are one pixel each in textures stretched over the maze
+			(tiles of at most 4096 boxes a side, so big mazes are covered too),
+			and only pixels of boxes that changed are uploaded again
+*/
+void draw_maze(const Maze&, int blockSize, const Camera2D&);
+void draw_box(const Maze&, int blockSize);
+// A dot for every agent inside the view
+void draw_agents(const std::vector<Pos>& agents, int blockSize, const Camera2D&);
+// Free the textures (before CloseWindow)
+void unload_drawing();
+
+#endif
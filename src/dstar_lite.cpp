@@ -0,0 +1,190 @@
+#include "dstar_lite.hpp"
+#include <algorithm>
+#include <chrono>
+#include <utility>
+
+DStarLite::DStarLite(const Maze& maze, Pos start, Pos goal)
+{
+	reset(maze, start, goal);
+}
+
+void DStarLite::reset(const Maze& m, Pos from, Pos to)
+{
+	snapshot.reset();
+	maze = &m;
+	col = int(m.width()), row = int(m.height());
+	start = lastStart = from, goal = to;
+	km = 0;
+
+	g.assign(size_t(col) * row, INF);
+	rhs.assign(size_t(col) * row, INF);
+	open.clear();
+
+	// Everything starts out as far as it can be, except the goal
+	if (in_maze(goal))
+	{
+		int i = box_index(goal);
+		rhs[i] = 0;
+		open.push({key(i), i});
+	}
+}
+
+void DStarLite::reset(MazeSnapshot m, Pos from, Pos to)
+{
+	reset(*m, from, to);
+	snapshot = std::move(m);
+}
+
+DStarLite::Key DStarLite::key(int i) const
+{
+	int best = std::min(g[i], rhs[i]);
+	if (best >= INF)
+		return {INF, INF};
+	return {best + box_pos(i).distance(start) + km, best};
+}
+
+void DStarLite::update(const Pos& p)
+{
+	if (!in_maze(p))
+		return;
+
+	int i = box_index(p);
+	if (p != goal)
+	{
+		int best = INF;
+		for (const Pos& n : maze->paths(p))
+			best = std::min(best, g[box_index(n)] + 1);
+		rhs[i] = std::min(best, int(INF));
+	}
+	if (g[i] != rhs[i])
+	{
+		open.push({key(i), i});
+		stats.pushed++;
+	}
+}
+
+void DStarLite::settle()
+{
+	if (!in_maze(start))
+		return;
+	const int s = box_index(start);
+
+	while (!open.empty())
+	{
+		const Entry top = open.top();
+		if (!(top.key < key(s)) && g[s] == rhs[s])
+			break;
+		open.pop();
+
+		// Settled since it was pushed, or pushed again with a lower key (that one comes first)
+		const int i = top.box;
+		const Key now = key(i);
+		if (g[i] == rhs[i] || now < top.key)
+		{
+			stats.duplicatePops++;
+			continue;
+		}
+		// The start moved since, so the key is too low: back in with the right one
+		if (top.key < now)
+		{
+			open.push({now, i});
+			continue;
+		}
+
+		expanded++;
+		const Pos p = box_pos(i);
+		if (g[i] > rhs[i])
+			// Closer than it was, which makes its neighbours closer too
+			g[i] = rhs[i];
+		else
+		{
+			// Further than it was: forget its distance and work it out again
+			g[i] = INF;
+			update(p);
+		}
+		for (const Pos& n : maze->paths(p))
+			update(n);
+
+		stats.peakFrontier = std::max(stats.peakFrontier, open.size());
+	}
+}
+
+void DStarLite::wall_changed(const Pos& one, const Pos& two)
+{
+	if (maze == nullptr)
+		return;
+	update(one);
+	update(two);
+}
+
+void DStarLite::wall_changed(MazeSnapshot now, const Pos& one, const Pos& two)
+{
+	if (maze == nullptr || now->width() != maze->width() || now->height() != maze->height())
+		return;
+	snapshot = std::move(now);
+	maze = snapshot.get();
+	wall_changed(one, two);
+}
+
+void DStarLite::move_start(Pos to)
+{
+	// Every key still in the open list is low by at most how far the start moved
+	km += lastStart.distance(to);
+	start = lastStart = to;
+}
+
+SearchResult DStarLite::replan()
+{
+	SearchResult res {};
+	if (maze == nullptr || !in_maze(start) || !in_maze(goal))
+		return res;
+
+	auto t0 = std::chrono::steady_clock::now();
+	stats = SearchStats {};
+	expanded = 0;
+	settle();
+
+	// Walk down the distances to the goal
+	int i = box_index(start);
+	if (g[i] < INF)
+	{
+		Pos curr = start;
+		res.path.push_back(curr);
+		while (curr != goal && res.path.size() <= g.size())
+		{
+			Pos next = curr;
+			for (const Pos& n : maze->paths(curr))
+			{
+				if (g[box_index(n)] < g[box_index(next)])
+					next = n;
+			}
+			if (next == curr)
+				break;
+			curr = next;
+			res.path.push_back(curr);
+		}
+		res.found = (curr == goal);
+		if (!res.found)
+			res.path.clear();
+	}
+	res.pathLength = res.path.size();
+
+	res.expanded = expanded;
+	res.stats = stats;
+	res.stats.peakBytes = bytes();
+	res.stats.ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+		std::chrono::steady_clock::now() - t0).count();
+	return res;
+}
+
+int DStarLite::distance(const Pos& p) const
+{
+	if (!in_maze(p) || g[box_index(p)] >= INF)
+		return -1;
+	return g[box_index(p)];
+}
+
+size_t DStarLite::bytes() const
+{
+	return (g.capacity() + rhs.capacity()) * sizeof(int) + open.capacity() * sizeof(Entry);
+}
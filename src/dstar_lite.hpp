@@ -0,0 +1,99 @@
+#ifndef DSTAR_LITE_H_
+#define DSTAR_LITE_H_
+
+#include "maze.hpp"
+#include "solver.hpp"
+#include <cstdint>
+#include <queue>
+#include <vector>
+
+// Shortest path that is repaired instead of searched again when walls change (D* Lite)
+/*
+	Searches backwards, from the goal, like A* but keeping two costs per box:
+		g, the distance it was last explored with, and
+		rhs, one more than its cheapest open neighbour's g (0 for the goal).
+	A box whose two costs agree is settled. An edit only changes the rhs of
+		the two boxes it separates or joins, so only they go back in the open list,
+		and replan() settles just the boxes whose distance really changed
+		(and that could be on a shortest path), not the whole maze again.
+
+	Tell it about every edit with wall_changed() (after the maze has changed),
+		then replan(). The start may also move (an agent walking along the path)
+		without starting over: the keys in the open list are kept as they are
+		and [km] makes up for the heuristic having shrunk.
+
+	The open list leaves entries in place when a box is pushed again;
+		old ones are skipped when popped.
+*/
+class DStarLite
+{
+private:
+	// {estimated cost, distance from the goal}, compared in that order
+	struct Key
+	{
+		int cost, dist;
+		bool operator<(const Key& o) const { return cost < o.cost || (cost == o.cost && dist < o.dist); }
+	};
+	struct Entry
+	{
+		Key key;
+		int box;
+		bool operator>(const Entry& o) const { return o.key < key; }
+	};
+	struct Open : std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry>>
+	{
+		void clear() { c.clear(); }
+		size_t capacity() const { return c.capacity(); }
+	};
+
+	MazeSnapshot snapshot {}; // Keeps [maze] alive when it was handed over as a snapshot
+	const Maze *maze = nullptr;
+	int col = 0, row = 0;
+	Pos start, goal, lastStart;
+	int km = 0;
+	std::vector<int> g {}, rhs {};
+	Open open {};
+	// Work of the last replan()
+	SearchStats stats {};
+	size_t expanded = 0;
+
+	enum : int { INF = 1 << 29 };
+
+	int box_index(const Pos& p) const { return p.y * col + p.x; }
+	Pos box_pos(int i) const { return {i % col, i / col}; }
+	bool in_maze(const Pos& p) const { return p.x >= 0 && p.y >= 0 && p.x < col && p.y < row; }
+	Key key(int i) const;
+	// Work out the rhs of a box again, and put it in the open list if it's not settled
+	void update(const Pos&);
+	// Settle boxes until the start's distance is right
+	void settle();
+
+public:
+	DStarLite() = default;
+	DStarLite(const Maze&, Pos start, Pos goal);
+
+	// Start over on [maze] (nothing is known about it yet), which must outlive the planner
+	void reset(const Maze&, Pos start, Pos goal);
+	// Same, but the planner keeps the snapshot alive itself
+	void reset(MazeSnapshot, Pos start, Pos goal);
+	// The walls between boxes [one] and [two] changed (call after the maze did)
+	void wall_changed(const Pos& one, const Pos& two);
+	// Same, when the edit went to a copy ([now]), which is held and read from then on
+	//  (the old snapshot can be let go of right away)
+	void wall_changed(MazeSnapshot now, const Pos& one, const Pos& two);
+	// The path should begin at [start] from now on
+	void move_start(Pos start);
+
+	// Shortest path from the start to the goal as it is now
+	//  (expanded and the stats only count the work this call did)
+	SearchResult replan();
+
+	// Steps from a box to the goal as of the last replan() (-1 if it can't get there)
+	int distance(const Pos&) const;
+	bool ready(const Maze& m) const { return maze == &m; }
+	Pos from() const { return start; }
+	Pos to() const { return goal; }
+	size_t bytes() const;
+};
+
+#endif
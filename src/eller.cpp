@@ -0,0 +1,188 @@
+#include "eller.hpp"
+#include "generator.hpp"
+#include "maze.hpp"
+#include <fstream>
+#include <numeric>
+
+/*
+	Every box of the current row belongs to a set; boxes in the same set are
+		already connected through rows above (or this one).
+	For each row:
+		1. Boxes without a set get a new one of their own.
+		2. Neighbours in different sets are randomly joined (open the wall to the right,
+			merge the sets). Joining the same set twice would make a loop, so it never happens.
+		3. Every set opens at least one path down (randomly more), so no set is cut off.
+			Boxes below an open path keep the set, the rest start over in step 1.
+	The last row joins every neighbour still in a different set, which connects everything.
+
+	Sets are labelled 0 to w - 1 and relabelled every row, so a union-find
+		of size [w] is all that's needed.
+*/
+void generate_rows(int w, std::uint64_t h, std::uint64_t seed,
+	const std::function<void(const MazeRow&)>& emit)
+{
+	if (w <= 0 || h == 0)
+		return;
+
+	Random rng {seed};
+	MazeRow row {};
+	row.right.assign(w, false);
+	row.down.assign(w, false);
+
+	// Set of each box (-1 if none yet), and union-find over set labels
+	std::vector<int> label(w, -1), parent(w), members(w), relabel(w);
+	std::vector<char> used(w), opened(w);
+
+	auto find = [&](int i)
+	{
+		while (parent[i] != i)
+			i = parent[i] = parent[parent[i]];
+		return i;
+	};
+
+	for (std::uint64_t y = 0; y < h; y++)
+	{
+		const bool last = (y + 1 == h);
+		row.y = y;
+
+		// 1. New sets for boxes without one
+		std::fill(used.begin(), used.end(), 0);
+		for (int x = 0; x < w; x++)
+		{
+			if (label[x] != -1)
+				used[label[x]] = 1;
+		}
+		for (int x = 0, free = 0; x < w; x++)
+		{
+			if (label[x] != -1)
+				continue;
+			while (used[free])
+				free++;
+			used[free] = 1;
+			label[x] = free;
+		}
+		std::iota(parent.begin(), parent.end(), 0);
+
+		// 2. Join neighbours
+		for (int x = 0; x + 1 < w; x++)
+		{
+			int a = find(label[x]), b = find(label[x + 1]);
+			row.right[x] = (a != b) && (last || (rng.next() & 1));
+			if (row.right[x])
+				parent[b] = a;
+		}
+		row.right[w - 1] = false;
+
+		// 3. Paths down
+		std::fill(row.down.begin(), row.down.end(), false);
+		if (!last)
+		{
+			std::fill(members.begin(), members.end(), 0);
+			std::fill(opened.begin(), opened.end(), 0);
+			for (int x = 0; x < w; x++)
+				members[find(label[x])]++;
+
+			for (int x = 0; x < w; x++)
+			{
+				int set = find(label[x]);
+				// Forced when this is the last box of a set that hasn't gone down yet
+				bool mustOpen = (--members[set] == 0) && !opened[set];
+				row.down[x] = mustOpen || (rng.next() & 1);
+				opened[set] |= row.down[x];
+			}
+		}
+
+		emit(row);
+
+		// Boxes below an open path keep their (relabelled) set
+		std::fill(relabel.begin(), relabel.end(), -1);
+		int next = 0;
+		for (int x = 0; x < w; x++)
+		{
+			if (!row.down[x])
+			{
+				label[x] = -1;
+				continue;
+			}
+			int set = find(label[x]);
+			if (relabel[set] == -1)
+				relabel[set] = next++;
+			label[x] = relabel[set];
+		}
+	}
+}
+
+void generate_rows(int w, std::uint64_t h, std::uint64_t seed, std::ostream& out)
+{
+	const size_t bytes = (size_t(w) + 7) / 8;
+	std::vector<char> buffer(bytes * 2);
+
+	generate_rows(w, h, seed, [&](const MazeRow& row)
+	{
+		std::fill(buffer.begin(), buffer.end(), 0);
+		for (int x = 0; x < w; x++)
+		{
+			buffer[x / 8] |= char(row.right[x] << (x % 8));
+			buffer[bytes + x / 8] |= char(row.down[x] << (x % 8));
+		}
+		out.write(buffer.data(), buffer.size());
+	});
+}
+
+// Vertex row y of [Maze] needs the walls above row y and left of its boxes,
+//  so each one is written as soon as row y arrives (row h is only the bottom border)
+bool generate_file(int w, int h, std::uint64_t seed, const std::string& path)
+{
+	std::ofstream out {path, std::ios::binary | std::ios::trunc};
+	if (!out || w <= 0 || h <= 0)
+		return false;
+
+	MazeInfo info {};
+	info.seed = seed, info.generator = ELLER;
+	write_maze_header(out, w, h, info);
+
+	// Vertices don't line up with bytes at the end of a row, so bits are
+	//  collected in [pending] and whole bytes written out
+	const std::uint8_t RIGHT = 1, DOWN = 2;
+	std::vector<char> buffer {};
+	std::uint8_t pending = 0;
+	int count = 0;
+	auto put = [&](std::uint8_t edges)
+	{
+		pending |= edges << (count * 2);
+		if (++count == 4)
+		{
+			buffer.push_back(char(pending));
+			pending = 0, count = 0;
+		}
+	};
+
+	std::vector<bool> downAbove(w, false);
+	auto vertex_row = [&](const MazeRow *row)
+	{
+		for (int x = 0; x <= w; x++)
+		{
+			std::uint8_t edges = 0;
+			// Top wall of box x, unless the row above opened a path down through it
+			if (x < w && !(row != nullptr && row->y > 0 && downAbove[x]))
+				edges |= RIGHT;
+			// Left wall of box x, unless box x - 1 opened a path right
+			if (row != nullptr && (x == 0 || x == w || !row->right[x - 1]))
+				edges |= DOWN;
+			put(edges);
+		}
+		out.write(buffer.data(), buffer.size());
+		buffer.clear();
+	};
+
+	generate_rows(w, h, seed, [&](const MazeRow& row)
+	{
+		vertex_row(&row);
+		downAbove = row.down;
+	});
+	vertex_row(nullptr);
+	if (count > 0)
+		out.put(char(pending));
+
+	return bool(out.flush());
+}
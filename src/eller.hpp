@@ -0,0 +1,39 @@
+#ifndef ELLER_H_
+#define ELLER_H_
+
+#include <cstdint>
+#include <functional>
+#include <ostream>
+#include <string>
+#include <vector>
+
+// One row of a maze made by generate_rows()
+struct MazeRow
+{
+	std::uint64_t y = 0;
+	// Per box: is there an open path to the box on the right / below
+	std::vector<bool> right {}, down {};
+};
+
+// Eller's algorithm
+/*
+	Makes a perfect maze one row at a time, keeping only the current row in memory,
+		so memory is proportional to [w] no matter how many rows there are.
+	Each finished row is handed to [emit] and then forgotten.
+	The same width, height and seed always give the same maze.
+*/
+void generate_rows(int w, std::uint64_t h, std::uint64_t seed,
+	const std::function<void(const MazeRow&)>& emit);
+
+// Stream the rows into [out] as they are made
+/*
+	Every row is written as ceil(w / 8) bytes of [right] bits followed by
+		ceil(w / 8) bytes of [down] bits (box x is bit x % 8 of byte x / 8).
+*/
+void generate_rows(int w, std::uint64_t h, std::uint64_t seed, std::ostream& out);
+
+// Stream the rows into a maze file (see maze.hpp) that Maze::load can open
+// Returns false if [path] can't be written
+bool generate_file(int w, int h, std::uint64_t seed, const std::string& path);
+
+#endif
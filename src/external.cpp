@@ -0,0 +1,204 @@
+#include "external.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <vector>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+// Half a byte per box, living in a file rather than in memory
+/*
+	The file is unlinked as soon as it's made, so it's gone once this is,
+		even if the process dies half way.
+	Bits 0-1: direction of the parent (index into [moves])
+	Bit 2: reached
+*/
+class Scratch
+{
+private:
+	std::uint8_t *bytes = nullptr;
+	size_t length = 0;
+
+public:
+	Scratch(const std::string& dir, std::uint64_t boxes)
+	{
+		std::string name = dir + "/maze-scratch-XXXXXX";
+		int fd = mkstemp(&name[0]);
+		if (fd == -1)
+			return;
+		unlink(name.c_str());
+
+		// Grows the file without writing anything, so it starts out all zeros
+		length = size_t((boxes + 1) / 2);
+		void *base = MAP_FAILED;
+		if (length > 0 && ftruncate(fd, off_t(length)) == 0)
+			base = mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+		close(fd);
+		if (base != MAP_FAILED)
+			bytes = (std::uint8_t*)base;
+	}
+	~Scratch()
+	{
+		if (bytes != nullptr)
+			munmap(bytes, length);
+	}
+	Scratch(const Scratch&) = delete;
+	Scratch& operator=(const Scratch&) = delete;
+
+	bool ok() const { return bytes != nullptr; }
+
+	std::uint8_t get(std::uint64_t i) const { return (bytes[i >> 1] >> ((i & 1) << 2)) & 0xF; }
+	void set(std::uint64_t i, std::uint8_t value)
+		{ bytes[i >> 1] |= std::uint8_t(value << ((i & 1) << 2)); }
+};
+
+enum : std::uint8_t { REACHED = 4 };
+// Directions a parent can be in: up, down, left, right (same order as Maze::paths)
+static const int moves[4][2] = {{0, -1}, {0, 1}, {-1, 0}, {1, 0}};
+
+// Direction from [from] to [to], two neighbours
+static std::uint8_t direction(const Pos& from, const Pos& to)
+{
+	for (std::uint8_t d = 0; d < 4; d++)
+	{
+		if (from.x + moves[d][0] == to.x && from.y + moves[d][1] == to.y)
+			return d;
+	}
+	return 0;
+}
+
+/*
+	A*: the Manhattan distance is consistent and every step costs 1, so a box
+		popped from the open list already has its shortest distance, and
+		f = g + h only ever stays the same or grows by 2 from a box to its neighbour.
+	That leaves just two buckets (f and f + 2) instead of a heap, and no costs to keep per box:
+		a bucket entry is the box and the way it came from (index * 4 + direction),
+		and the box records its parent when it's popped, not when it's pushed.
+	Within a bucket, the last one pushed (the deepest) goes first.
+*/
+bool solve_external(const Maze& maze, Pos start, Pos end, int alg, SearchResult& res,
+	const std::string& scratchDir)
+{
+	res = SearchResult {};
+	const int col = int(maze.width()), row = int(maze.height());
+	auto in_maze = [&](const Pos& p) { return p.x >= 0 && p.y >= 0 && p.x < col && p.y < row; };
+	if (!in_maze(start) || !in_maze(end))
+		return true;
+
+	auto index = [&](const Pos& p) { return std::uint64_t(p.y) * col + p.x; };
+	auto pos = [&](std::uint64_t i) { return Pos(int(i % col), int(i / col)); };
+
+	Scratch state {scratchDir, std::uint64_t(col) * row};
+	if (!state.ok())
+		return false;
+
+	const std::uint64_t target = index(end);
+	const bool aStar = (alg == A_STAR || alg == BI_A_STAR);
+	SearchStats& stats = res.stats;
+	auto t0 = std::chrono::steady_clock::now();
+
+	if (!aStar)
+	{
+		std::vector<std::uint64_t> layer {index(start)}, next {};
+		state.set(index(start), REACHED);
+		stats.pushed = stats.peakFrontier = 1;
+
+		while (!layer.empty() && !(state.get(target) & REACHED))
+		{
+			std::sort(layer.begin(), layer.end());
+			for (size_t k = 0; k < layer.size(); k++)
+			{
+				res.expanded++;
+				Pos curr = pos(layer[k]);
+				for (Pos p : maze.paths(curr))
+				{
+					std::uint64_t j = index(p);
+					if (state.get(j) & REACHED)
+						continue;
+					state.set(j, REACHED | direction(p, curr));
+					next.push_back(j);
+					// What's left of this layer and what's in the next one
+					stats.pushed++;
+					stats.peakFrontier = std::max(stats.peakFrontier, layer.size() - k - 1 + next.size());
+				}
+			}
+			layer.swap(next);
+			next.clear();
+		}
+		// Neither ever gives memory back, so their capacity is the most they held
+		stats.peakBytes = (layer.capacity() + next.capacity()) * sizeof(std::uint64_t);
+	}
+	else
+	{
+		std::vector<std::uint64_t> bucket[2] {};
+		int f = start.distance(end), curr = 0;
+		bucket[curr].push_back(index(start) * 4);
+		stats.pushed = stats.peakFrontier = 1;
+
+		while (!bucket[0].empty() || !bucket[1].empty())
+		{
+			if (bucket[curr].empty())
+			{
+				curr ^= 1;
+				f += 2;
+			}
+
+			std::uint64_t entry = bucket[curr].back();
+			bucket[curr].pop_back();
+			std::uint64_t i = entry / 4;
+			// Pushed more than once before it was popped
+			if (state.get(i) & REACHED)
+			{
+				stats.duplicatePops++;
+				continue;
+			}
+
+			state.set(i, REACHED | std::uint8_t(entry & 3));
+			res.expanded++;
+			if (i == target)
+				break;
+
+			Pos box = pos(i);
+			for (Pos p : maze.paths(box))
+			{
+				std::uint64_t j = index(p);
+				if (state.get(j) & REACHED)
+					continue;
+				// h went down by one: same f, otherwise f + 2
+				int b = (p.distance(end) < box.distance(end)) ? curr : curr ^ 1;
+				bucket[b].push_back(j * 4 + direction(p, box));
+				stats.pushed++;
+			}
+			stats.peakFrontier = std::max(stats.peakFrontier, bucket[0].size() + bucket[1].size());
+		}
+		stats.peakBytes = (bucket[0].capacity() + bucket[1].capacity()) * sizeof(std::uint64_t);
+	}
+
+	auto elapsed = [&]
+	{
+		return std::uint64_t(std::chrono::duration_cast<std::chrono::nanoseconds>(
+			std::chrono::steady_clock::now() - t0).count());
+	};
+	if (!(state.get(target) & REACHED))
+	{
+		stats.ns = elapsed();
+		return true;
+	}
+
+	// Follow the parents back from the end
+	res.found = true;
+	for (Pos p = end; ; )
+	{
+		res.path.push_back(p);
+		if (p == start)
+			break;
+		const int *d = moves[state.get(index(p)) & 3];
+		p = {p.x + d[0], p.y + d[1]};
+	}
+	std::reverse(res.path.begin(), res.path.end());
+	res.pathLength = res.path.size();
+	stats.ns = elapsed();
+
+	return true;
+}
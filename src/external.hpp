@@ -0,0 +1,31 @@
+#ifndef EXTERNAL_H_
+#define EXTERNAL_H_
+
+#include "maze.hpp"
+#include "solver.hpp"
+#include <string>
+
+// Searches for mazes too big for memory
+/*
+	Meant for a maze opened with Maze::load, so the walls are read from the mapped file.
+	The search keeps half a byte per box (reached flag and the way back to its parent)
+		in a scratch file under [scratchDir], mapped into memory,
+		so the kernel can write it out and read it back as memory runs short.
+	There's no default for [scratchDir]: /tmp is often tmpfs (memory itself),
+		so pick a directory on a disk, such as the maze file's.
+	Nothing per box is kept in RAM; only the frontier is, which in a maze
+		is a thin band of boxes compared to the whole grid.
+
+	BFS (and DFS, which just needs any path) goes one layer at a time, and each layer
+		is sorted by box index first, so boxes and walls are visited front to back
+		through both files and page faults stay mostly sequential.
+	A* (and the bidirectional searches) is shortest-path only; see solve_external() in external.cpp.
+
+	Returns false if the scratch file can't be made, otherwise [res] holds the result.
+	Its stats count the frontier only: peakBytes is what it held in RAM,
+		the scratch file isn't included.
+*/
+bool solve_external(const Maze&, Pos start, Pos end, int algIndex, SearchResult& res,
+	const std::string& scratchDir);
+
+#endif
@@ -0,0 +1,110 @@
+#include "flow_field.hpp"
+
+FlowField::FlowField(const Maze& maze, Pos goal)
+{
+	build(maze, goal);
+}
+
+void FlowField::build(const Maze& maze, Pos goal)
+{
+	col = int(maze.width()), row = int(maze.height());
+	target = goal;
+	const size_t n = size_t(col) * row;
+	dist.assign(n, -1);
+	dir.assign(n, NONE);
+	order.clear();
+	if (!in_maze(goal))
+		return;
+
+	int g = index(goal);
+	dist[g] = 0, dir[g] = HERE;
+	order.push_back(g);
+
+	// [order] is the BFS queue too; everything before [i] is done
+	for (size_t i = 0; i < order.size(); i++)
+	{
+		int curr = order[i];
+		Pos c = pos(curr);
+		for (Pos next : maze.paths(c))
+		{
+			int j = index(next);
+			if (dist[j] != -1)
+				continue;
+
+			dist[j] = dist[curr] + 1;
+			// [next] steps back toward [c]
+			if (c.y < next.y)
+				dir[j] = UP;
+			else if (c.y > next.y)
+				dir[j] = DOWN;
+			else if (c.x < next.x)
+				dir[j] = LEFT;
+			else
+				dir[j] = RIGHT;
+			order.push_back(j);
+		}
+	}
+}
+
+bool FlowField::reaches(const Pos& p) const
+{
+	return in_maze(p) && dist[index(p)] != -1;
+}
+
+int FlowField::distance(const Pos& p) const
+{
+	return in_maze(p) ? dist[index(p)] : -1;
+}
+
+FlowField::Dir FlowField::direction(const Pos& p) const
+{
+	return in_maze(p) ? dir[index(p)] : NONE;
+}
+
+Pos FlowField::next(const Pos& p) const
+{
+	switch (direction(p))
+	{
+		case UP:
+			return {p.x, p.y - 1};
+		case DOWN:
+			return {p.x, p.y + 1};
+		case LEFT:
+			return {p.x - 1, p.y};
+		case RIGHT:
+			return {p.x + 1, p.y};
+		default:
+			return p;
+	}
+}
+
+std::vector<Pos> FlowField::path(const Pos& start) const
+{
+	std::vector<Pos> boxes {};
+	if (!reaches(start))
+		return boxes;
+
+	boxes.reserve(dist[index(start)] + 1);
+	Pos curr = start;
+	boxes.push_back(curr);
+	while (curr != target)
+	{
+		curr = next(curr);
+		boxes.push_back(curr);
+	}
+	return boxes;
+}
+
+SearchResult FlowField::solve(const Pos& start) const
+{
+	SearchResult res {};
+	res.path = path(start);
+	res.found = !res.path.empty();
+	res.pathLength = res.path.size();
+	return res;
+}
+
+size_t FlowField::bytes() const
+{
+	return dist.capacity() * sizeof(int) + dir.capacity() * sizeof(Dir) + order.capacity() * sizeof(int);
+}
@@ -0,0 +1,60 @@
+#ifndef FLOW_FIELD_H_
+#define FLOW_FIELD_H_
+
+#include "maze.hpp"
+#include "solver.hpp"
+#include <vector>
+
+// Which way to go from every box to reach one goal
+/*
+	Many agents heading for the same box would all search for nearly the same path.
+	Instead one BFS from the goal (every path works both ways) gives each box
+		its distance to the goal and the neighbour one step closer.
+	Any number of agents can then follow the arrows with no searching at all,
+		each in time proportional to the length of its path.
+
+	It stays right until the maze changes; build() again after that
+		(or for another goal), which reuses the memory.
+*/
+class FlowField
+{
+public:
+	// Way out of a box toward the goal
+	enum Dir : unsigned char { UP, DOWN, LEFT, RIGHT, HERE, NONE };
+
+private:
+	int col = 0, row = 0;
+	Pos target {-1, -1};
+	// Indexed by y * width + x
+	std::vector<int> dist {}; // Steps to the goal (-1 if it can't be reached)
+	std::vector<Dir> dir {};
+	// Boxes in the order the BFS reached them
+	std::vector<int> order {};
+
+	int index(const Pos& p) const { return p.y * col + p.x; }
+	Pos pos(int i) const { return {i % col, i / col}; }
+	bool in_maze(const Pos& p) const { return p.x >= 0 && p.y >= 0 && p.x < col && p.y < row; }
+
+public:
+	FlowField() = default;
+	FlowField(const Maze&, Pos goal);
+
+	// Point every box of [maze] at [goal] (nothing reaches a goal outside the maze)
+	void build(const Maze&, Pos goal);
+
+	Pos goal() const { return target; }
+	bool reaches(const Pos&) const;
+	// Steps to the goal (-1 if there is no way)
+	int distance(const Pos&) const;
+	Dir direction(const Pos&) const;
+	// The box to move to next (the same box at the goal or with no way to it)
+	Pos next(const Pos&) const;
+	// Boxes from [start] to the goal (empty if there is no way)
+	std::vector<Pos> path(const Pos& start) const;
+	// path() as a SearchResult, like the other searches
+	SearchResult solve(const Pos& start) const;
+
+	size_t bytes() const;
+};
+
+#endif
@@ -1,111 +1,459 @@
 #include "generator.hpp"
+#include "eller.hpp"
 #include "maze.hpp"
 #include <ctime>
-#include <cstdlib>
-#include <stack>
-#include "raylib.h"
+#include <algorithm>
+#include <atomic>
+#include <numeric>
+#include <thread>
+#include <vector>
 
-Maze *maze = nullptr;
+// Seeds are spread out with splitmix64, so nearby seeds give unrelated mazes
+Random::Random(std::uint64_t seed)
+{
+	for (std::uint64_t& word : s)
+	{
+		std::uint64_t z = (seed += 0x9E3779B97F4A7C15ull);
+		z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+		z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+		word = z ^ (z >> 31);
+	}
+}
 
-// Generate a maze with randomized DFS
+std::uint64_t Random::next()
+{
+	auto rotl = [](std::uint64_t x, int k) { return (x << k) | (x >> (64 - k)); };
+
+	std::uint64_t result = rotl(s[1] * 5, 7) * 9;
+	std::uint64_t t = s[1] << 17;
+	s[2] ^= s[0], s[3] ^= s[1], s[1] ^= s[2], s[0] ^= s[3];
+	s[2] ^= t;
+	s[3] = rotl(s[3], 45);
+
+	return result;
+}
+
+// One bit per box
+struct Bitset
+{
+	std::vector<std::uint64_t> words;
+
+	explicit Bitset(size_t n) : words((n + 63) / 64, 0) {}
+	bool test(size_t i) const { return (words[i >> 6] >> (i & 63)) & 1; }
+	void set(size_t i) { words[i >> 6] |= std::uint64_t(1) << (i & 63); }
+};
+
+// Boxes are numbered y * w + x in the generators
+static Pos box(int i, int w) { return {i % w, i / w}; }
+
+// Boxes next to [i] that [unvisited] says yes to
+template <typename F>
+static int neighbours(int i, int w, int h, int (&out)[4], F unvisited)
+{
+	int count = 0, x = i % w, y = i / w;
+	if (y > 0 && unvisited(i - w))
+		out[count++] = i - w;
+	if (y + 1 < h && unvisited(i + w))
+		out[count++] = i + w;
+	if (x > 0 && unvisited(i - 1))
+		out[count++] = i - 1;
+	if (x + 1 < w && unvisited(i + 1))
+		out[count++] = i + 1;
+	return count;
+}
+
+// Randomized DFS (iterative backtracker)
 /*
-	Algorithm starts at a given vertex, and randomly picks only a single neighbour
-		that has not been looked at before (it doesn't look at *each* neighbour).
-	Then it removes the edge connecting the vertex to its neighbour.
-	It then looks at the chosen (just removed) neighbour and add the current vertex again
-		(so it can remove another neighbour if it has the opportunity)
-
-	In this way, it ends up removing one edge from each visited vertex.
-	In our case, a vertex has 4 or less neighbours, so when the algorithm runs,
-		it removes an edge from a vertex and marks the vertex as visited, therefore,
-		we can't remove an edge containing this vertex again.
-	This is why this algorithm doesn't just remove all edges
-
-	Why it creates a maze pattern is still unknown to me
-	- Oba
+	Starts at the top-left box, and randomly picks a single neighbour
+		that has not been looked at before.
+	Then it removes the wall between the box and its neighbour and
+		carries on from the neighbour.
+	When a box has no unvisited neighbours left, it backtracks (pops the stack)
+		until it finds one that does.
+
+	Every box is visited once, by opening exactly one wall into it,
+		so the boxes end up forming a tree: a perfect maze with long, winding corridors.
 */
-const Maze& generate_maze(int w, int h)
+static void backtracker(Maze& maze, int w, int h, Random& rng)
 {
-	if (maze != nullptr)
-		return *maze;
+	Bitset visited (size_t(w) * h);
+	// Stack used instead of recursion
+	std::vector<int> stack {0};
+	visited.set(0);
 
-	std::srand(std::time(NULL));
+	while (!stack.empty())
+	{
+		int curr = stack.back(), next[4];
+		int count = neighbours(curr, w, h, next, [&](int i) { return !visited.test(i); });
+		if (count == 0)
+		{
+			stack.pop_back();
+			continue;
+		}
 
-	maze = new Maze(w, h);
-	
-	// Vertices we've accessed at any point
-	std::unordered_set<Pos> explored {}; 
-	// Stack used instead of recursion
-	std::stack<Pos> nexts {};
-
-	// We've seen the first vertex
-	explored.insert({0, 0});
-	nexts.push(*explored.begin());
-	while (!nexts.empty())
-	{
-		Pos curr = nexts.top();
-		nexts.pop();
-
-		// Holds neighbouring vertices that have not been visited
-		std::vector<Pos> unvisited = maze->walls(curr);
-		// Remove vertices that have been visited
-		unvisited.erase(
-			std::remove_if(unvisited.begin(), unvisited.end(),
-				[explored](Pos p) { return (explored.find(p) != explored.end()); }),
-			unvisited.end()
-		);
-
-		// If they are walls that have not been visited	
-		if (!unvisited.empty())
+		int pick = next[rng.below(count)];
+		maze.open_path(box(curr, w), box(pick, w));
+		visited.set(pick);
+		stack.push_back(pick);
+	}
+}
+
+// Randomized Kruskal's algorithm
+/*
+	Every box starts in its own set. The inner walls are shuffled, and
+		a wall is removed only if the boxes on both sides are in different sets
+		(which are then joined), so no loop is ever made.
+	Sets are kept in a union-find (with path halving and union by size).
+*/
+static void kruskal(Maze& maze, int w, int h, Random& rng)
+{
+	const int n = w * h;
+	std::vector<int> parent(n), size(n, 1);
+	std::iota(parent.begin(), parent.end(), 0);
+
+	auto find = [&](int i)
+	{
+		while (parent[i] != i)
+			i = parent[i] = parent[parent[i]];
+		return i;
+	};
+
+	// Wall below box i is i * 2, wall to its right is i * 2 + 1
+	std::vector<std::uint32_t> walls {};
+	walls.reserve(size_t(n) * 2);
+	for (int i = 0; i < n; i++)
+	{
+		if (i / w + 1 < h)
+			walls.push_back(std::uint32_t(i) * 2);
+		if (i % w + 1 < w)
+			walls.push_back(std::uint32_t(i) * 2 + 1);
+	}
+
+	// Fisher-Yates shuffle
+	for (size_t i = walls.size(); i > 1; i--)
+		std::swap(walls[i - 1], walls[rng.below(std::uint32_t(i))]);
+
+	int joined = 0;
+	for (std::uint32_t wall : walls)
+	{
+		int a = int(wall / 2), b = (wall & 1) ? a + 1 : a + w;
+		int ra = find(a), rb = find(b);
+		if (ra == rb)
+			continue;
+
+		if (size[ra] < size[rb])
+			std::swap(ra, rb);
+		parent[rb] = ra, size[ra] += size[rb];
+		maze.open_path(box(a, w), box(b, w));
+
+		// A tree of n boxes has n - 1 paths
+		if (++joined == n - 1)
+			break;
+	}
+}
+
+// Randomized Prim's algorithm
+/*
+	Grows the maze from the top-left box. The frontier is every box next to the maze
+		but not in it yet; a random one is picked, joined to a random neighbour that
+		is already in the maze, and its own neighbours join the frontier.
+	This makes lots of short dead ends.
+*/
+static void prim(Maze& maze, int w, int h, Random& rng)
+{
+	const int n = w * h;
+	Bitset inMaze (n), inFrontier (n);
+	std::vector<int> frontier {};
+
+	auto add = [&](int i)
+	{
+		inMaze.set(i);
+		int next[4];
+		int count = neighbours(i, w, h, next,
+			[&](int j) { return !inMaze.test(j) && !inFrontier.test(j); });
+		for (int k = 0; k < count; k++)
+		{
+			inFrontier.set(next[k]);
+			frontier.push_back(next[k]);
+		}
+	};
+
+	add(0);
+	while (!frontier.empty())
+	{
+		// Swap a random one to the back and take it
+		std::swap(frontier[rng.below(std::uint32_t(frontier.size()))], frontier.back());
+		int curr = frontier.back();
+		frontier.pop_back();
+
+		int next[4];
+		int count = neighbours(curr, w, h, next, [&](int j) { return inMaze.test(j); });
+		maze.open_path(box(curr, w), box(next[rng.below(count)], w));
+		add(curr);
+	}
+}
+
+// Wilson's algorithm
+/*
+	Starts with one box in the maze. From a box outside it, walk randomly
+		until the maze is hit, remembering only the last way out of every box
+		(which erases the loops of the walk). That path is then added to the maze.
+	Repeat from the next box outside the maze.
+
+	Every perfect maze is equally likely to come out, but the first walks
+		can take a long time on big grids.
+*/
+static void wilson(Maze& maze, int w, int h, Random& rng)
+{
+	const int n = w * h;
+	Bitset inMaze (n);
+	// Last way out of each box during the current walk
+	std::vector<int> exit(n, -1);
+	inMaze.set(0);
+
+	for (int start = 1; start < n; start++)
+	{
+		if (inMaze.test(start))
+			continue;
+
+		// Random walk until it hits the maze
+		for (int curr = start; !inMaze.test(curr); curr = exit[curr])
+		{
+			int next[4];
+			int count = neighbours(curr, w, h, next, [](int) { return true; });
+			exit[curr] = next[rng.below(count)];
+		}
+
+		// Add the loop-erased path
+		for (int curr = start; !inMaze.test(curr); curr = exit[curr])
 		{
-			// Check current vertex again (sometime later)
-			nexts.push(curr);
-
-			// Pick a random vertex from [unvisited]
-			Pos randomVert = unvisited[std::rand() % unvisited.size()];
-			// Remove wall (edge) connecting the two vertices
-			maze->remove_wall(curr, randomVert);
-
-			// I've already seen the above vertex
-			explored.insert(randomVert);
-			// Look at it next
-			nexts.push(randomVert);
+			inMaze.set(curr);
+			maze.open_path(box(curr, w), box(exit[curr], w));
 		}
 	}
+}
 
-	return *maze;
+Maze generate(int w, int h, std::uint64_t seed, int algorithm)
+{
+	Maze result (w, h);
+	if (w <= 0 || h <= 0)
+		return result;
+
+	Random rng {seed};
+	switch (algorithm)
+	{
+		case KRUSKAL:
+			kruskal(result, w, h, rng);
+			break;
+		case PRIM:
+			prim(result, w, h, rng);
+			break;
+		case WILSON:
+			wilson(result, w, h, rng);
+			break;
+		case ELLER:
+			generate_rows(w, h, seed, [&](const MazeRow& row)
+			{
+				const int y = int(row.y);
+				for (int x = 0; x < w; x++)
+				{
+					if (row.right[x])
+						result.open_path({x, y}, {x + 1, y});
+					if (row.down[x])
+						result.open_path({x, y}, {x, y + 1});
+				}
+			});
+			break;
+		default:
+			backtracker(result, w, h, rng);
+			break;
+	}
+
+	return result;
 }
 
-// Use DrawLines to connect vertices (an edge)
-void draw_maze(int w, int h, int blockSize)
+// Tiled generation
+/*
+	1. Every tile gets its own seed (drawn up front from [seed]) and is made as
+		a small maze of its own, so tiles don't depend on each other or on the order they're made in.
+	2. The tiles are copied into the big maze a band (row of tiles) at a time.
+		Neighbouring bands can share a byte of [Maze::edges] where they meet,
+		so even bands are done first and odd bands after, never both at once.
+	3. Randomized Kruskal's over the tile grid picks which neighbouring tiles to join,
+		and one random wall on the border of each such pair is opened.
+	Each tile is a tree and the tiles are joined in a tree, so the whole maze is one too.
+*/
+Maze generate_tiled(int w, int h, std::uint64_t seed, int algorithm, unsigned threads, int tileSize)
 {
-	if (maze == nullptr)
-		return;
+	Maze result (w, h);
+	if (w <= 0 || h <= 0)
+		return result;
+	if (tileSize <= 0)
+		tileSize = 256;
 
-	for (int i = 0; i <= h; i++)
+	const int tilesX = (w + tileSize - 1) / tileSize, tilesY = (h + tileSize - 1) / tileSize;
+	const int tiles = tilesX * tilesY;
+
+	Random rng {seed};
+	std::vector<std::uint64_t> seeds(tiles);
+	for (std::uint64_t& s : seeds)
+		s = rng.next();
+
+	auto copy_band = [&](int ty)
 	{
-		for (int j = 0; j <= w; j++)
+		const int y0 = ty * tileSize, th = std::min(tileSize, h - y0);
+		for (int tx = 0; tx < tilesX; tx++)
 		{
-			// i represents the current row
-			// j represents the current column
-			Pos pos = {j, i};
-			if (!maze->is_vertex(pos))
-				continue;
-
-			// Starting point
-			Vector2 start = {float(pos.x) * blockSize, float(pos.y) * blockSize};
-			for (Pos p : maze->walls(pos))
+			const int x0 = tx * tileSize, tw = std::min(tileSize, w - x0);
+			Maze tile = generate(tw, th, seeds[ty * tilesX + tx], algorithm);
+
+			for (int y = 0; y < th; y++)
 			{
-				// Ending point
-				Vector2 end = {float(p.x) * blockSize, float(p.y) * blockSize};
-				DrawLineV(start, end, WHITE);
+				for (int x = 0; x < tw; x++)
+				{
+					// Wall on the right of the box / below it
+					if (x + 1 < tw && !tile.is_wall({x + 1, y}, {x + 1, y + 1}))
+						result.open_path({x0 + x, y0 + y}, {x0 + x + 1, y0 + y});
+					if (y + 1 < th && !tile.is_wall({x, y + 1}, {x + 1, y + 1}))
+						result.open_path({x0 + x, y0 + y}, {x0 + x, y0 + y + 1});
+				}
 			}
 		}
+	};
+
+	if (threads == 0)
+		threads = std::max(1u, std::thread::hardware_concurrency());
+	threads = std::min(threads, unsigned(tilesY + 1) / 2);
+
+	for (int parity = 0; parity < 2; parity++)
+	{
+		// Bands parity, parity + 2, ... handed out one at a time
+		std::atomic<int> next {parity};
+		auto worker = [&]()
+		{
+			for (int ty; (ty = next.fetch_add(2)) < tilesY; )
+				copy_band(ty);
+		};
+
+		std::vector<std::thread> pool {};
+		for (unsigned t = 1; t < threads; t++)
+			pool.emplace_back(worker);
+		worker();
+
+		for (std::thread& t : pool)
+			t.join();
+	}
+
+	// Join the tiles (tile borders are numbered like the walls in kruskal())
+	std::vector<int> parent(tiles);
+	std::iota(parent.begin(), parent.end(), 0);
+	auto find = [&](int i)
+	{
+		while (parent[i] != i)
+			i = parent[i] = parent[parent[i]];
+		return i;
+	};
+
+	std::vector<std::uint32_t> borders {};
+	for (int i = 0; i < tiles; i++)
+	{
+		if (i / tilesX + 1 < tilesY)
+			borders.push_back(std::uint32_t(i) * 2);
+		if (i % tilesX + 1 < tilesX)
+			borders.push_back(std::uint32_t(i) * 2 + 1);
+	}
+	for (size_t i = borders.size(); i > 1; i--)
+		std::swap(borders[i - 1], borders[rng.below(std::uint32_t(i))]);
+
+	for (std::uint32_t border : borders)
+	{
+		int a = int(border / 2), b = (border & 1) ? a + 1 : a + tilesX;
+		int ra = find(a), rb = find(b);
+		if (ra == rb)
+			continue;
+		parent[rb] = ra;
+
+		const int x0 = (a % tilesX) * tileSize, y0 = (a / tilesX) * tileSize;
+		if (border & 1)
+		{
+			// Left/right tiles: a random box along the shared column
+			int y = y0 + int(rng.below(std::uint32_t(std::min(tileSize, h - y0))));
+			int x = x0 + tileSize - 1;
+			result.open_path({x, y}, {x + 1, y});
+		}
+		else
+		{
+			int x = x0 + int(rng.below(std::uint32_t(std::min(tileSize, w - x0))));
+			int y = y0 + tileSize - 1;
+			result.open_path({x, y}, {x, y + 1});
+		}
 	}
+
+	return result;
+}
+
+// Braiding
+/*
+	Dead ends (boxes with one way out) are visited in a random order and
+		[fraction] of them get a second way out. Each one that is still a dead end
+		by its turn has a wall knocked down, into another dead end if it can
+		(so one wall fixes two), otherwise into any neighbour.
+	A perfect maze has one path between any two boxes; after braiding it has
+		loops and many equally short ways round, much like open maps with obstacles.
+*/
+size_t braid(Maze& maze, double fraction, std::uint64_t seed)
+{
+	const int w = int(maze.width()), h = int(maze.height());
+	Random rng {seed};
+
+	std::vector<int> deadEnds {};
+	for (int i = 0; i < w * h; i++)
+	{
+		if (maze.paths(box(i, w)).size() == 1)
+			deadEnds.push_back(i);
+	}
+	// Fisher-Yates, with [rng] so the seed decides
+	for (size_t i = deadEnds.size(); i > 1; i--)
+		std::swap(deadEnds[i - 1], deadEnds[rng.below(std::uint32_t(i))]);
+
+	fraction = std::max(0.0, std::min(1.0, fraction));
+	deadEnds.resize(size_t(deadEnds.size() * fraction + 0.5));
+
+	size_t opened = 0;
+	for (int i : deadEnds)
+	{
+		const Pos p = box(i, w);
+		const Neighbours ways = maze.paths(p);
+		if (ways.size() != 1)
+			continue;
+
+		// Walled-off neighbours (all but the way out), dead ends first
+		int out[4];
+		int count = neighbours(i, w, h, out, [&](int j) { return box(j, w) != ways[0]; });
+		int pick = -1;
+		for (int k = 0; k < count && pick == -1; k++)
+		{
+			if (maze.paths(box(out[k], w)).size() == 1)
+				pick = out[k];
+		}
+		if (pick == -1 && count > 0)
+			pick = out[rng.below(std::uint32_t(count))];
+
+		if (pick != -1 && maze.open_path(p, box(pick, w)))
+			opened++;
+	}
+
+	return opened;
+}
+
+MazeSnapshot generate_maze(int w, int h)
+{
+	return generate_maze(w, h, std::time(NULL));
 }
 
-void free_maze()
+// The pattern is picked by [seed], so it can be reproduced
+// (the maze is moved into the snapshot, not copied)
+MazeSnapshot generate_maze(int w, int h, unsigned seed)
 {
-	if (maze != nullptr)
-		delete maze;
+	return std::make_shared<const Maze>(generate(w, h, seed));
 }
@@ -1,5 +1,45 @@
+#ifndef GENERATOR_H_
+#define GENERATOR_H_
+
 #include "maze.hpp"
+#include <cstdint>
+
+// ELLER builds the maze from generate_rows() (eller.hpp), which can also stream it without a Maze
+enum MazeAlgorithm : int { BACKTRACKER = 0, KRUSKAL, PRIM, WILSON, ELLER, NUM_MAZE_ALGORITHMS };
+
+// Small, fast random number generator (xoshiro256**)
+// The same seed gives the same numbers on every machine, unlike std::rand()
+class Random
+{
+private:
+	std::uint64_t s[4];
+
+public:
+	explicit Random(std::uint64_t seed);
+
+	std::uint64_t next();
+	// Number in [0, n)
+	std::uint32_t below(std::uint32_t n)
+		{ return std::uint32_t(((next() >> 32) * n) >> 32); }
+};
+
+// Generate a perfect maze (exactly one path between any two boxes)
+// The same size, seed and algorithm always give the same maze
+Maze generate(int w, int h, std::uint64_t seed, int algorithm = BACKTRACKER);
+
+// Same, but the grid is cut into [tileSize] x [tileSize] tiles that are generated on [threads] workers
+//  (0 means one per core) and joined by a random spanning tree over the tiles
+// The maze only depends on the seed and tile size, not on how many threads made it
+Maze generate_tiled(int w, int h, std::uint64_t seed, int algorithm = BACKTRACKER,
+	unsigned threads = 0, int tileSize = 256);
+
+// Knock down walls of [fraction] (0 to 1) of the dead ends, so the maze gets loops
+// A dead end opens into a neighbouring dead end when it has one (fixing both at once)
+// Returns how many walls were knocked down
+size_t braid(Maze&, double fraction, std::uint64_t seed);
+
+// A new maze to be shared (nothing is kept here, it goes once its last holder lets go)
+MazeSnapshot generate_maze(int w, int h);
+MazeSnapshot generate_maze(int w, int h, unsigned seed);
 
-const Maze& generate_maze(int w, int h);
-void draw_maze(int w, int h, int blockSize);
-void free_maze();
\ No newline at end of file
+#endif
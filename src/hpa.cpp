@@ -0,0 +1,400 @@
+#include "hpa.hpp"
+#include <algorithm>
+#include <chrono>
+#include <unordered_map>
+
+HpaGraph::HpaGraph(const Maze& m, int clusterSize)
+	: maze(&m), col(int(m.width())), row(int(m.height())), size(std::max(1, clusterSize))
+{
+	clustersX = (col + size - 1) / size, clustersY = (row + size - 1) / size;
+	const int numClusters = clustersX * clustersY;
+	localSeen.assign(size_t(size) * size, 0);
+	localDist.assign(size_t(size) * size, 0);
+	localWays.assign(size_t(size) * size, 0);
+	localParent.assign(size_t(size) * size, 0);
+
+	// Regions: every box gets the number of the part of its cluster it's connected to
+	std::vector<int> region(size_t(col) * row, -1);
+	int regions = 0;
+	std::vector<Pos> stack {};
+	for (int y = 0; y < row; y++)
+	{
+		for (int x = 0; x < col; x++)
+		{
+			if (region[size_t(y) * col + x] != -1)
+				continue;
+			const int c = cluster_of({x, y});
+			region[size_t(y) * col + x] = regions;
+			stack.push_back({x, y});
+			while (!stack.empty())
+			{
+				Pos p = stack.back();
+				stack.pop_back();
+				for (const Pos& n : maze->paths(p))
+				{
+					int& r = region[size_t(n.y) * col + n.x];
+					if (r == -1 && cluster_of(n) == c)
+						r = regions, stack.push_back(n);
+				}
+			}
+			regions++;
+		}
+	}
+
+	// Entrances: passages spread along every group that joins the same two regions
+	// (one in the middle of a long group makes a path that only needs its end go a long way round)
+	const int gap = std::max(1, size / 4);
+	std::unordered_map<int, int> nodeOf {};
+	auto node_at = [&](const Pos& p)
+	{
+		auto known = nodeOf.find(p.y * col + p.x);
+		if (known != nodeOf.end())
+			return known->second;
+		nodes.push_back(p);
+		nodeOf[p.y * col + p.x] = int(nodes.size()) - 1;
+		return int(nodes.size()) - 1;
+	};
+	auto is_open = [&](const Pos& a, const Pos& b)
+	{
+		for (const Pos& n : maze->paths(a))
+		{
+			if (n == b)
+				return true;
+		}
+		return false;
+	};
+
+	struct Crossing { int from, to; Pos a, b; };
+	std::vector<Crossing> crossings {};
+	std::vector<std::pair<int, int>> links {};
+	// Crossings along one side of a cluster, in order
+	auto add_side = [&]
+	{
+		std::stable_sort(crossings.begin(), crossings.end(), [](const Crossing& one, const Crossing& two)
+			{ return one.from < two.from || (one.from == two.from && one.to < two.to); });
+		for (size_t i = 0, j = 0; i < crossings.size(); i = j)
+		{
+			while (j < crossings.size() && crossings[j].from == crossings[i].from && crossings[j].to == crossings[i].to)
+				j++;
+			// Both ends of the group, and a passage every [gap] boxes between them
+			int last = -gap;
+			for (size_t k = i; k < j; k++)
+			{
+				const int along = crossings[k].a.x + crossings[k].a.y;
+				if (along - last >= gap || k + 1 == j)
+					links.push_back({node_at(crossings[k].a), node_at(crossings[k].b)}), last = along;
+			}
+		}
+		crossings.clear();
+	};
+
+	for (int cy = 0; cy < clustersY; cy++)
+	{
+		for (int cx = 0; cx < clustersX; cx++)
+		{
+			const int x0 = cx * size, y0 = cy * size;
+			const int x1 = std::min(x0 + size, col), y1 = std::min(y0 + size, row);
+			// Right side
+			for (int y = y0; x1 < col && y < y1; y++)
+			{
+				Pos a {x1 - 1, y}, b {x1, y};
+				if (is_open(a, b))
+					crossings.push_back({region[size_t(y) * col + a.x], region[size_t(y) * col + b.x], a, b});
+			}
+			add_side();
+			// Bottom side
+			for (int x = x0; y1 < row && x < x1; x++)
+			{
+				Pos a {x, y1 - 1}, b {x, y1};
+				if (is_open(a, b))
+					crossings.push_back({region[size_t(a.y) * col + x], region[size_t(b.y) * col + x], a, b});
+			}
+			add_side();
+		}
+	}
+	std::vector<int>().swap(region);
+
+	// Entrances by cluster
+	clusterStart.assign(numClusters + 1, 0);
+	for (const Pos& p : nodes)
+		clusterStart[cluster_of(p) + 1]++;
+	for (int c = 0; c < numClusters; c++)
+		clusterStart[c + 1] += clusterStart[c];
+	clusterNodes.resize(nodes.size());
+	std::vector<int> fill(clusterStart.begin(), clusterStart.end() - 1);
+	for (int n = 0; n < int(nodes.size()); n++)
+		clusterNodes[fill[cluster_of(nodes[n])]++] = n;
+
+	// Edges: the links across clusters, and the distances inside each one
+	std::vector<std::pair<int, Edge>> all {};
+	for (const auto& link : links)
+	{
+		all.push_back({link.first, {link.second, 1}});
+		all.push_back({link.second, {link.first, 1}});
+	}
+	for (int c = 0; c < numClusters; c++)
+	{
+		for (int k = clusterStart[c]; k < clusterStart[c + 1]; k++)
+		{
+			const int u = clusterNodes[k];
+			flood_cluster(nodes[u]);
+			for (int l = clusterStart[c]; l < clusterStart[c + 1]; l++)
+			{
+				const int v = clusterNodes[l];
+				const int i = local(nodes[v]);
+				if (v != u && localSeen[i] == localEpoch)
+					all.push_back({u, {v, localDist[i]}});
+			}
+		}
+	}
+
+	adjStart.assign(nodes.size() + 1, 0);
+	for (const auto& e : all)
+		adjStart[e.first + 1]++;
+	for (size_t n = 0; n < nodes.size(); n++)
+		adjStart[n + 1] += adjStart[n];
+	edges.resize(all.size());
+	fill.assign(adjStart.begin(), adjStart.end() - 1);
+	for (const auto& e : all)
+		edges[fill[e.first]++] = e.second;
+
+	// The start and end of a query are the last two
+	seen.assign(nodes.size() + 2, 0);
+	g.assign(nodes.size() + 2, 0);
+	parent.assign(nodes.size() + 2, 0);
+}
+
+void HpaGraph::next_local()
+{
+	if (localEpoch == UINT32_MAX)
+	{
+		std::fill(localSeen.begin(), localSeen.end(), 0);
+		localEpoch = 0;
+	}
+	localEpoch++;
+}
+
+// Bits 0 to 3: a way left, right, up and down (the order of [step] in the floods)
+void HpaGraph::load_ways(int c)
+{
+	if (waysOf == c)
+		return;
+	waysOf = c;
+	for (int i = 0; i < size * size; i++)
+	{
+		const Pos p = global(c, i);
+		localWays[i] = 0;
+		if (!in_maze(p))
+			continue;
+		for (const Pos& n : maze->paths(p))
+		{
+			if (cluster_of(n) != c)
+				continue;
+			localWays[i] |= n.x < p.x ? 1 : n.x > p.x ? 2 : n.y < p.y ? 4 : 8;
+		}
+	}
+}
+
+size_t HpaGraph::flood_cluster(const Pos& from)
+{
+	next_local();
+	load_ways(cluster_of(from));
+	const int step[] {-1, 1, -size, size};
+	localQueue.clear();
+	localQueue.push_back(local(from));
+	localSeen[local(from)] = localEpoch;
+	localDist[local(from)] = 0;
+
+	for (size_t head = 0; head < localQueue.size(); head++)
+	{
+		const int i = localQueue[head];
+		for (int w = 0; w < 4; w++)
+		{
+			const int j = i + step[w];
+			if ((localWays[i] >> w) & 1 && localSeen[j] != localEpoch)
+			{
+				localSeen[j] = localEpoch;
+				localDist[j] = localDist[i] + 1;
+				localQueue.push_back(j);
+			}
+		}
+	}
+	return localQueue.size();
+}
+
+size_t HpaGraph::walk_cluster(const Pos& from, const Pos& to, std::vector<Pos>& path)
+{
+	next_local();
+	const int c = cluster_of(from);
+	load_ways(c);
+	const int step[] {-1, 1, -size, size};
+	const int target = local(to);
+	open.clear();
+	localSeen[local(from)] = localEpoch;
+	localDist[local(from)] = 0;
+	localParent[local(from)] = local(from);
+	open.push({from.distance(to), local(from)});
+
+	size_t expanded = 0;
+	while (!open.empty())
+	{
+		const Item top = open.top();
+		open.pop();
+		const int i = top.second;
+		const Pos p = global(c, i);
+		// Left behind when a cheaper way was found
+		if (top.first > localDist[i] + p.distance(to))
+			continue;
+		if (i == target)
+			break;
+
+		expanded++;
+		for (int w = 0; w < 4; w++)
+		{
+			const int j = i + step[w];
+			if (!((localWays[i] >> w) & 1))
+				continue;
+			if (localSeen[j] != localEpoch || localDist[i] + 1 < localDist[j])
+			{
+				localSeen[j] = localEpoch;
+				localDist[j] = localDist[i] + 1;
+				localParent[j] = i;
+				open.push({localDist[j] + global(c, j).distance(to), j});
+			}
+		}
+	}
+
+	if (localSeen[target] != localEpoch)
+		return expanded;
+	const size_t first = path.size();
+	for (int i = target; i != localParent[i]; i = localParent[i])
+		path.push_back(global(c, i));
+	std::reverse(path.begin() + first, path.end());
+	return expanded;
+}
+
+SearchResult HpaGraph::solve(Pos start, Pos end)
+{
+	SearchResult res {};
+	if (maze == nullptr || !in_maze(start) || !in_maze(end))
+		return res;
+	auto t0 = std::chrono::steady_clock::now();
+
+	const int N = int(nodes.size()), S = N, G = N + 1;
+	const int cs = cluster_of(start), ce = cluster_of(end);
+	auto at = [&](int n) { return n == S ? start : (n == G ? end : nodes[n]); };
+	if (epoch == UINT32_MAX)
+	{
+		std::fill(seen.begin(), seen.end(), 0);
+		epoch = 0;
+	}
+	epoch++;
+
+	// Join the end to the entrances of its cluster (and see if the start is right there)
+	size_t looked = flood_cluster(end);
+	std::vector<int> toEnd {};
+	for (int k = clusterStart[ce]; k < clusterStart[ce + 1]; k++)
+	{
+		const int i = local(nodes[clusterNodes[k]]);
+		toEnd.push_back(localSeen[i] == localEpoch ? localDist[i] : -1);
+	}
+	const int direct = (cs == ce && localSeen[local(start)] == localEpoch) ? localDist[local(start)] : -1;
+
+	// And the start
+	looked += flood_cluster(start);
+	std::vector<Edge> fromStart {};
+	for (int k = clusterStart[cs]; k < clusterStart[cs + 1]; k++)
+	{
+		const int i = local(nodes[clusterNodes[k]]);
+		if (localSeen[i] == localEpoch)
+			fromStart.push_back({clusterNodes[k], localDist[i]});
+	}
+	if (direct >= 0)
+		fromStart.push_back({G, direct});
+
+	// A* over the entrances
+	open.clear();
+	auto relax = [&](int u, int v, int w)
+	{
+		const int cost = g[u] + w;
+		if (seen[v] != epoch || cost < g[v])
+		{
+			seen[v] = epoch, g[v] = cost, parent[v] = u;
+			open.push({cost + at(v).distance(end), v});
+			res.stats.pushed++;
+		}
+	};
+	seen[S] = epoch, g[S] = 0, parent[S] = S;
+	open.push({start.distance(end), S});
+
+	size_t expanded = 0;
+	while (!open.empty())
+	{
+		const Item top = open.top();
+		open.pop();
+		const int u = top.second;
+		if (top.first > g[u] + at(u).distance(end))
+		{
+			res.stats.duplicatePops++;
+			continue;
+		}
+		if (u == G)
+			break;
+
+		expanded++;
+		if (u == S)
+		{
+			for (const Edge& e : fromStart)
+				relax(S, e.to, e.weight);
+			continue;
+		}
+		for (int k = adjStart[u]; k < adjStart[u + 1]; k++)
+			relax(u, edges[k].to, edges[k].weight);
+		if (cluster_of(nodes[u]) == ce)
+		{
+			const int *first = clusterNodes.data() + clusterStart[ce], *last = clusterNodes.data() + clusterStart[ce + 1];
+			const int slot = int(std::find(first, last, u) - first);
+			if (toEnd[slot] >= 0)
+				relax(u, G, toEnd[slot]);
+		}
+		res.stats.peakFrontier = std::max(res.stats.peakFrontier, open.size());
+	}
+
+	if (seen[G] == epoch)
+	{
+		std::vector<int> chain {};
+		for (int n = G; n != S; n = parent[n])
+			chain.push_back(n);
+		chain.push_back(S);
+		std::reverse(chain.begin(), chain.end());
+
+		// Fill in every edge: a step across a border, or a walk inside a cluster
+		res.path.push_back(start);
+		for (size_t k = 1; k < chain.size(); k++)
+		{
+			const Pos from = at(chain[k - 1]), to = at(chain[k]);
+			if (cluster_of(from) != cluster_of(to))
+				res.path.push_back(to);
+			else if (from != to)
+				looked += walk_cluster(from, to, res.path);
+		}
+		res.found = true;
+		res.pathLength = res.path.size();
+	}
+
+	res.expanded = expanded + looked;
+	res.stats.peakBytes = bytes();
+	res.stats.ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+		std::chrono::steady_clock::now() - t0).count();
+	return res;
+}
+
+size_t HpaGraph::bytes() const
+{
+	return nodes.capacity() * sizeof(Pos) + edges.capacity() * sizeof(Edge)
+		+ (adjStart.capacity() + clusterStart.capacity() + clusterNodes.capacity()) * sizeof(int)
+		+ seen.capacity() * sizeof(std::uint32_t) + (g.capacity() + parent.capacity()) * sizeof(int)
+		+ localSeen.capacity() * sizeof(std::uint32_t) + localWays.capacity()
+		+ (localDist.capacity() + localParent.capacity() + localQueue.capacity()) * sizeof(int)
+		+ open.capacity() * sizeof(Item);
+}
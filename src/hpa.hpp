@@ -0,0 +1,98 @@
+#ifndef HPA_H_
+#define HPA_H_
+
+#include "maze.hpp"
+#include "solver.hpp"
+#include <cstdint>
+#include <queue>
+#include <vector>
+
+// Hierarchical A* (HPA*): a search over clusters of boxes first, then box by box
+/*
+	Built once per maze:
+		- The maze is cut into [size] x [size] clusters, and every cluster into
+			the parts that are connected inside it (regions).
+		- Where two clusters meet, the passages across are grouped by the two regions
+			they join. Both ends of each group, and a passage every [size] / 4 boxes
+			between them, become entrances: a box on either side, joined by an edge of 1.
+			Any passage across a group could be taken, so keeping only some
+			loses no way through, only a few steps here and there.
+		- Within a cluster every pair of entrances that can reach each other gets
+			an edge as long as the shortest way between them inside the cluster.
+
+	A query joins the start and end to the entrances of their clusters (BFS inside them),
+		runs A* over the entrances, and then fills in each edge of the result
+		with an A* that stays inside its cluster.
+	A loopy maze has only a few regions per cluster, so this graph is tiny next to
+		the maze and a long query looks at a small fraction of what A* over boxes does.
+	Paths are shortest up to where the entrances are (usually within a few percent).
+*/
+class HpaGraph
+{
+private:
+	struct Edge { int to, weight; };
+	// {cost, node or box}, cheapest first (clear() keeps the storage)
+	typedef std::pair<int, int> Item;
+	struct MinQueue : std::priority_queue<Item, std::vector<Item>, std::greater<Item>>
+	{
+		void clear() { c.clear(); }
+		size_t capacity() const { return c.capacity(); }
+	};
+
+	const Maze *maze = nullptr;
+	int col = 0, row = 0, size = 0;
+	int clustersX = 0, clustersY = 0;
+
+	std::vector<Pos> nodes {}; // The entrances
+	// Edges of node i are edges[adjStart[i]] ... edges[adjStart[i + 1] - 1]
+	std::vector<int> adjStart {};
+	std::vector<Edge> edges {};
+	// Entrances of cluster c are clusterNodes[clusterStart[c]] ... [clusterStart[c + 1] - 1]
+	std::vector<int> clusterStart {}, clusterNodes {};
+
+	// Scratch of one query, kept between them (so solve() isn't const, one graph per thread)
+	// Per node, plus the start and end (the last two):
+	std::uint32_t epoch = 0;
+	std::vector<std::uint32_t> seen {};
+	std::vector<int> g {}, parent {};
+	// Per box of one cluster
+	std::uint32_t localEpoch = 0;
+	std::vector<std::uint32_t> localSeen {};
+	std::vector<int> localDist {}, localParent {}, localQueue {};
+	// Passages of one cluster, that stay inside it (a bit per way, see WAYS), so floods
+	//  don't ask the maze for every box again
+	int waysOf = -1;
+	std::vector<unsigned char> localWays {};
+	MinQueue open {};
+
+	int cluster_of(const Pos& p) const { return (p.y / size) * clustersX + p.x / size; }
+	bool in_maze(const Pos& p) const { return p.x >= 0 && p.y >= 0 && p.x < col && p.y < row; }
+	// Box of cluster [c] as an index into the local scratch (and back)
+	int local(const Pos& p) const { return (p.y % size) * size + p.x % size; }
+	Pos global(int c, int i) const { return {(c % clustersX) * size + i % size, (c / clustersX) * size + i / size}; }
+	void next_local();
+	// [localWays] for cluster [c]
+	void load_ways(int c);
+
+	// BFS from [from] inside its cluster; [localDist] has the steps to every box it reached
+	//  (in [localSeen] for [localEpoch]), returns how many that was
+	size_t flood_cluster(const Pos& from);
+	// A* from [from] to [to] inside their cluster, adding the boxes after [from] to [path]
+	//  returns how many boxes it expanded
+	size_t walk_cluster(const Pos& from, const Pos& to, std::vector<Pos>& path);
+
+public:
+	HpaGraph() = default;
+	explicit HpaGraph(const Maze&, int clusterSize = 32);
+
+	size_t num_nodes() const { return nodes.size(); }
+	size_t num_edges() const { return edges.size(); }
+	size_t bytes() const;
+
+	// [expanded] counts entrances expanded and boxes looked at inside clusters (joining the
+	//  start and end, and filling in the path)
+	// The maze it was built from has to stay alive and unchanged
+	SearchResult solve(Pos start, Pos end);
+};
+
+#endif
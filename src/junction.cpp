@@ -0,0 +1,367 @@
+#include "junction.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+
+JunctionGraph::JunctionGraph(const Maze& maze)
+	: maze(&maze), col(int(maze.width())), row(int(maze.height()))
+{
+	const int n = col * row;
+
+	// Dead-end filling
+	// [degree] counts open paths to boxes that are still in the core
+	std::vector<int> degree(n);
+	std::vector<int> deadEnds {};
+	toward.assign(n, -1);
+	for (int i = 0; i < n; i++)
+	{
+		degree[i] = int(maze.paths(pos(i)).size());
+		if (degree[i] == 1)
+			deadEnds.push_back(i);
+	}
+
+	while (!deadEnds.empty())
+	{
+		int curr = deadEnds.back();
+		deadEnds.pop_back();
+		// Its last neighbour might have been filled in the meantime
+		if (toward[curr] != -1 || degree[curr] != 1)
+			continue;
+
+		for (Pos p : maze.paths(pos(curr)))
+		{
+			int next = index(p);
+			if (toward[next] != -1)
+				continue;
+
+			// Fill it, and its neighbour might be a dead end now
+			toward[curr] = next;
+			if (--degree[next] == 1)
+				deadEnds.push_back(next);
+		}
+	}
+
+	// Junctions are core boxes that are not in the middle of a corridor
+	junctionId.assign(n, -1);
+	cellEdge.assign(n, -1);
+	cellOffset.assign(n, -1);
+	for (int i = 0; i < n; i++)
+	{
+		if (toward[i] == -1 && degree[i] != 2)
+		{
+			junctionId[i] = int(junctions.size());
+			junctions.push_back(pos(i));
+		}
+	}
+
+	// Follow every corridor leaving junction [k] to the junction at its other end
+	auto trace = [&](int k)
+	{
+		Pos from = junctions[k];
+		for (Pos first : maze.paths(from))
+		{
+			int i = index(first);
+			if (toward[i] != -1)
+				continue;
+
+			// Two junctions next to each other
+			if (junctionId[i] != -1)
+			{
+				if (k < junctionId[i])
+					edges.push_back({k, junctionId[i], 1, first});
+				continue;
+			}
+			// Already followed from the other end
+			if (cellEdge[i] != -1)
+				continue;
+
+			int e = int(edges.size()), offset = 1;
+			Pos prev = from, curr = first;
+			while (junctionId[index(curr)] == -1)
+			{
+				cellEdge[index(curr)] = e;
+				cellOffset[index(curr)] = offset++;
+
+				Pos next = step(curr, prev);
+				prev = curr, curr = next;
+			}
+			edges.push_back({k, junctionId[index(curr)], offset, first});
+		}
+	};
+
+	for (int k = 0; k < int(junctions.size()); k++)
+		trace(k);
+
+	// Whatever is left are loops without a junction; make one up
+	for (int i = 0; i < n; i++)
+	{
+		if (toward[i] == -1 && junctionId[i] == -1 && cellEdge[i] == -1)
+		{
+			junctionId[i] = int(junctions.size());
+			junctions.push_back(pos(i));
+			trace(junctionId[i]);
+		}
+	}
+
+	// Adjacency list (a loop is listed twice under the same junction, once per direction)
+	adjStart.assign(junctions.size() + 1, 0);
+	for (const Edge& e : edges)
+		adjStart[e.a + 1]++, adjStart[e.b + 1]++;
+	for (size_t k = 0; k < junctions.size(); k++)
+		adjStart[k + 1] += adjStart[k];
+
+	adj.resize(adjStart.back());
+	std::vector<int> fill(adjStart.begin(), adjStart.end() - 1);
+	for (int e = 0; e < int(edges.size()); e++)
+	{
+		adj[fill[edges[e].a]++] = e * 2;
+		adj[fill[edges[e].b]++] = e * 2 + 1;
+	}
+	stamp.assign(junctions.size() + 2, 0);
+	dist.assign(junctions.size() + 2, 0);
+	parent.assign(junctions.size() + 2, -1);
+	via.assign(junctions.size() + 2, -1);
+}
+
+size_t JunctionGraph::core_size() const
+{
+	return std::count(toward.begin(), toward.end(), -1);
+}
+
+// Corridor boxes have exactly two open paths in the core
+Pos JunctionGraph::step(const Pos& curr, const Pos& prev) const
+{
+	for (Pos p : maze->paths(curr))
+	{
+		if (p != prev && toward[index(p)] == -1)
+			return p;
+	}
+	return prev;
+}
+
+std::vector<Pos> JunctionGraph::corridor(int e) const
+{
+	const Edge& edge = edges[e];
+	std::vector<Pos> boxes {junctions[edge.a]};
+	boxes.reserve(edge.weight + 1);
+
+	Pos prev = junctions[edge.a], curr = edge.first;
+	while (junctionId[index(curr)] == -1)
+	{
+		boxes.push_back(curr);
+		Pos next = step(curr, prev);
+		prev = curr, curr = next;
+	}
+	boxes.push_back(curr);
+
+	return boxes;
+}
+
+template <typename F>
+void JunctionGraph::arcs(int u, const Ends& ends, F relax) const
+{
+	const int S = int(junctions.size()), T = S + 1;
+	if (u == T)
+		return;
+
+	if (u == S)
+	{
+		const Edge& e = edges[ends.sEdge];
+		// Back to [a] or on to [b]
+		relax(e.a, ends.sOffset, ends.sEdge * 2 + 1);
+		relax(e.b, e.weight - ends.sOffset, ends.sEdge * 2);
+		// Straight down the corridor
+		if (ends.target == T && ends.tEdge == ends.sEdge)
+			relax(T, std::abs(ends.tOffset - ends.sOffset), ends.sEdge * 2 + (ends.tOffset < ends.sOffset));
+		return;
+	}
+
+	for (int i = adjStart[u]; i < adjStart[u + 1]; i++)
+	{
+		int e = adj[i] / 2;
+		bool fromA = !(adj[i] & 1);
+		const Edge& edge = edges[e];
+
+		relax(fromA ? edge.b : edge.a, edge.weight, adj[i]);
+		if (ends.target == T && e == ends.tEdge)
+			relax(T, fromA ? ends.tOffset : edge.weight - ends.tOffset, adj[i]);
+	}
+}
+
+/*
+	1. Both ends walk out of their dead ends into the core.
+		If they reach the core at the same box, they were in the same dead-end
+		tree and the path never leaves it.
+	2. An end sitting in a corridor becomes a temporary node (S or T),
+		joined to the two junctions of its corridor by the steps to each.
+	3. The search runs over junctions only.
+	4. Each edge used is filled back in with the boxes of its corridor.
+*/
+SearchResult JunctionGraph::solve(Pos start, Pos end, int alg)
+{
+	SearchResult res {};
+	if (maze == nullptr || !in_maze(start) || !in_maze(end))
+		return res;
+	auto t0 = std::chrono::steady_clock::now();
+	auto finish = [&]
+	{
+		res.pathLength = res.path.size();
+		res.stats.peakBytes = bytes();
+		res.stats.ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+			std::chrono::steady_clock::now() - t0).count();
+	};
+
+	// Ways from the ends to the core
+	std::vector<Pos> head {start}, tail {end};
+	for (int i = index(start); toward[i] != -1; i = toward[i])
+		head.push_back(pos(toward[i]));
+	for (int i = index(end); toward[i] != -1; i = toward[i])
+		tail.push_back(pos(toward[i]));
+
+	// Same dead-end tree, drop the shared part and join them where they split
+	if (head.back() == tail.back())
+	{
+		res.found = true;
+		while (head.size() > 1 && tail.size() > 1 && head[head.size() - 2] == tail[tail.size() - 2])
+			head.pop_back(), tail.pop_back();
+
+		res.path = head;
+		res.path.insert(res.path.end(), tail.rbegin() + 1, tail.rend());
+		finish();
+		return res;
+	}
+
+	const Pos sCore = head.back(), eCore = tail.back();
+	const int J = int(junctions.size()), S = J, T = J + 1;
+	Ends ends {};
+	ends.sEdge = cellEdge[index(sCore)], ends.tEdge = cellEdge[index(eCore)];
+	ends.sOffset = cellOffset[index(sCore)], ends.tOffset = cellOffset[index(eCore)];
+	ends.source = (ends.sEdge == -1) ? junctionId[index(sCore)] : S;
+	ends.target = (ends.tEdge == -1) ? junctionId[index(eCore)] : T;
+	const int source = ends.source, target = ends.target;
+
+	// New stamps (stamps never written are 0, so every epoch starts at 2 or more)
+	if (epoch > UINT32_MAX - 4)
+	{
+		std::fill(stamp.begin(), stamp.end(), 0);
+		epoch = 0;
+	}
+	epoch += 2;
+	auto reached = [&](int u) { return stamp[u] >= epoch; };
+	auto closed = [&](int u) { return stamp[u] == epoch + 1; };
+
+	auto node_pos = [&](int u) { return u == S ? sCore : (u == T ? eCore : junctions[u]); };
+
+	stamp[source] = epoch, dist[source] = 0;
+	res.stats.pushed = 1;
+	if (alg == DFS)
+	{
+		// Any path will do
+		stack.clear();
+		stack.push_back(source);
+		while (!stack.empty())
+		{
+			int u = stack.back();
+			stack.pop_back();
+			if (closed(u))
+			{
+				res.stats.duplicatePops++;
+				continue;
+			}
+
+			stamp[u] = epoch + 1;
+			res.expanded++;
+			if (u == target)
+				break;
+
+			arcs(u, ends, [&](int v, int cost, int how)
+			{
+				if (closed(v))
+					return;
+				stamp[v] = epoch, dist[v] = dist[u] + cost, parent[v] = u, via[v] = how;
+				stack.push_back(v);
+				res.stats.pushed++;
+			});
+			res.stats.peakFrontier = std::max(res.stats.peakFrontier, stack.size());
+		}
+	}
+	else
+	{
+		// Dijkstra, or A* with the Manhattan distance (corridors are never shorter than it)
+		bool informed = (alg == A_STAR || alg == BI_A_STAR);
+		auto h = [&](int u) { return informed ? node_pos(u).distance(eCore) : 0; };
+
+		open.clear();
+		open.push({h(source), source});
+		while (!open.empty())
+		{
+			int u = open.top().second;
+			open.pop();
+			if (closed(u))
+			{
+				res.stats.duplicatePops++;
+				continue;
+			}
+
+			stamp[u] = epoch + 1;
+			res.expanded++;
+			if (u == target)
+				break;
+
+			arcs(u, ends, [&](int v, int cost, int how)
+			{
+				if (closed(v) || (reached(v) && dist[u] + cost >= dist[v]))
+					return;
+				stamp[v] = epoch, dist[v] = dist[u] + cost, parent[v] = u, via[v] = how;
+				open.push({dist[v] + h(v), v});
+				res.stats.pushed++;
+			});
+			res.stats.peakFrontier = std::max(res.stats.peakFrontier, open.size());
+		}
+	}
+
+	if (!closed(target))
+	{
+		finish();
+		return res;
+	}
+
+	// Nodes from target back to source
+	std::vector<int> nodes {};
+	for (int u = target; u != source; u = parent[u])
+		nodes.push_back(u);
+	std::reverse(nodes.begin(), nodes.end());
+
+	res.found = true;
+	res.path = head;
+	int prev = source;
+	for (int u : nodes)
+	{
+		int e = via[u] / 2;
+		bool fromA = !(via[u] & 1);
+		std::vector<Pos> boxes = corridor(e);
+
+		// Where on the corridor the step starts and stops
+		int from = (prev == S) ? ends.sOffset : (fromA ? 0 : edges[e].weight);
+		int to = (u == T) ? ends.tOffset : (fromA ? edges[e].weight : 0);
+		int dir = (to > from) ? 1 : -1;
+		for (int i = from + dir; i != to + dir; i += dir)
+			res.path.push_back(boxes[i]);
+
+		prev = u;
+	}
+	res.path.insert(res.path.end(), tail.rbegin() + 1, tail.rend());
+	finish();
+
+	return res;
+}
+
+size_t JunctionGraph::bytes() const
+{
+	return junctions.capacity() * sizeof(Pos) + edges.capacity() * sizeof(Edge)
+		+ (adjStart.capacity() + adj.capacity() + junctionId.capacity() + cellEdge.capacity()
+			+ cellOffset.capacity() + toward.capacity()) * sizeof(int)
+		+ stamp.capacity() * sizeof(std::uint32_t)
+		+ (dist.capacity() + parent.capacity() + via.capacity() + stack.capacity()) * sizeof(int)
+		+ open.capacity() * sizeof(Item);
+}
@@ -0,0 +1,100 @@
+#ifndef JUNCTION_H_
+#define JUNCTION_H_
+
+#include "maze.hpp"
+#include "solver.hpp"
+#include <cstdint>
+#include <queue>
+#include <vector>
+
+// A smaller graph of only the boxes where paths split
+/*
+	Most boxes of a maze are dead ends or corridors (one or two open paths).
+	Built once per maze:
+		- Dead-end filling: boxes with one open path are removed over and over,
+			until what is left (the core) has no dead ends.
+			Every removed box remembers the way back to the core.
+		- Corridor contraction: core boxes with two open paths are folded into
+			weighted edges between the boxes that don't (junctions).
+
+	Searches then only look at junctions, and the boxes are filled back in
+		once a path is found.
+	Their scratch is kept between queries and never cleared (stamped per query, like
+		SearchContext), so solve() changes the graph: one per thread, like a SearchContext.
+*/
+class JunctionGraph
+{
+private:
+	// A corridor between two junctions
+	struct Edge
+	{
+		int a, b; // Junction ids
+		int weight; // Number of steps from [a] to [b]
+		Pos first; // Box after [a] on the way to [b]
+	};
+
+	const Maze *maze = nullptr;
+	int col = 0, row = 0;
+	std::vector<Pos> junctions {};
+	std::vector<Edge> edges {};
+	// Edges of junction i are adj[adjStart[i]] ... adj[adjStart[i + 1] - 1],
+	//  stored as edge * 2 when i is its [a] and edge * 2 + 1 when i is its [b]
+	std::vector<int> adjStart {}, adj {};
+
+	// Per box (indexed by y * width + x)
+	std::vector<int> junctionId {}; // -1 if not a junction
+	std::vector<int> cellEdge {}, cellOffset {}; // Corridor box: its edge and steps from the edge's [a]
+	std::vector<int> toward {}; // Filled box: next box on the way to the core (-1 if in the core)
+
+	// Scratch of one query, per junction plus the two ends (S and T, the last two)
+	// A node is reached when its stamp is [epoch] or more, and closed at [epoch] + 1
+	typedef std::pair<int, int> Item; // {cost, node}
+	struct MinQueue : std::priority_queue<Item, std::vector<Item>, std::greater<Item>>
+	{
+		void clear() { c.clear(); }
+		size_t capacity() const { return c.capacity(); }
+	};
+	std::uint32_t epoch = 0;
+	std::vector<std::uint32_t> stamp {};
+	// How each node was reached: from [parent] over [via] (edge * 2 + direction, like [adj])
+	std::vector<int> dist {}, parent {}, via {};
+	std::vector<int> stack {}; // DFS
+	MinQueue open {}; // Dijkstra and A*
+
+	// Where a query's ends join the junctions: a junction, or S and T
+	//  [offset] steps along [edge] (when the end is in a corridor, otherwise [edge] is -1)
+	struct Ends
+	{
+		int source, target;
+		int sEdge, sOffset, tEdge, tOffset;
+	};
+	// Calls [relax(to, cost, via)] for every way out of node [u]
+	template <typename F>
+	void arcs(int u, const Ends&, F relax) const;
+
+	int index(const Pos& p) const { return p.y * col + p.x; }
+	Pos pos(int i) const { return {i % col, i / col}; }
+	bool in_maze(const Pos& p) const { return p.x >= 0 && p.y >= 0 && p.x < col && p.y < row; }
+	// Every box of an edge, from [a] to [b]
+	std::vector<Pos> corridor(int edge) const;
+	// Next core box along a corridor
+	Pos step(const Pos& curr, const Pos& prev) const;
+
+public:
+	JunctionGraph() = default;
+	explicit JunctionGraph(const Maze&);
+
+	size_t num_junctions() const { return junctions.size(); }
+	size_t num_edges() const { return edges.size(); }
+	// Boxes left after dead-end filling
+	size_t core_size() const;
+	size_t bytes() const;
+
+	// DFS finds any path, the rest find the shortest
+	//  (BFS runs as Dijkstra since edges have weights, A* stays A*)
+	// The maze it was built from has to stay alive and unchanged
+	// Not const: it works in the graph's scratch
+	SearchResult solve(Pos start, Pos end, int algIndex);
+};
+
+#endif
@@ -2,6 +2,7 @@
 #if defined(PLATFORM_WEB)
 	#include "emscripten/emscripten.h"
 #endif
+#include <climits>
 #include <cstdlib>
 #include "generator.hpp"
 #include "maze.hpp"
@@ -11,10 +12,18 @@
 #include <algorithm>
 #include <sstream>
 #include "solver.hpp"
+#include "flow_field.hpp"
+#include "dstar_lite.hpp"
+#include "draw.hpp"
 
 void GameLoop();
+void move_camera(const Vector2&);
 void get_waypoint(const Vector2&, Vector2&, Pos&);
 void display_options(const std::string&, int, int);
+void display_stats(const SearchResult&, int, int);
+void send_agents();
+void move_agents();
+void toggle_wall(const Vector2&);
 
 // Not static because it is accessed in another file
 int width, height;
@@ -25,17 +34,35 @@ int width, height;
 static constexpr int blockSize = 25;
 static int w, h,
 		alg = -1, // index of algorithm running
-		stepTime_ms = 100; // time to next animation
+		lastAlg = -1, // index of the algorithm whose search is shown (-1 if none)
+		stepTime_ms = 100; // time to next animation (0: as fast as it can)
+static bool paused = false;
 
-static float timer = 0, animTimer = 0;
+static float timer = 0, animTimer = 0, agentTimer = 0;
 
-// Maze object
-static Maze maze;
+// Biggest window on desktop, bigger mazes are zoomed and panned
+static constexpr int maxWidth = 1280, maxHeight = 800;
+// World space is the maze at [blockSize] per box
+static Camera2D camera {};
+
+// Maze being shown, shared with the search thread (edits replace it, see toggle_wall())
+static MazeSnapshot maze;
 // User has dropped 0: start point; 1: end point
 static bool waypointsDropped[2] {false, false};
 static Vector2 waypoints[2] {}; // Position in world space of the waypoints 
 static Pos waypointsPos[2] {}; // Position in [Maze] of the waypoints
 
+// Agents heading for the end point, all following one flow field
+static constexpr int agentsPerPress = 100;
+static FlowField field {};
+static std::uint64_t fieldVersion = 0; // maze->version() [field] was built for (0: none, or the end point moved)
+static std::vector<Pos> agents {};
+static double fieldMs = 0; // Time it took to build [field]
+
+// Path between the waypoints, repaired as walls are edited
+static DStarLite planner {};
+static bool planned = false; // [planner] is for the current waypoints
+
 int main(int argc, char **argv)
 {
 	#if !defined(PLATFORM_WEB)
@@ -53,6 +80,11 @@ int main(int argc, char **argv)
 
 	width = w * blockSize;
 	height = h * blockSize;
+	#if !defined(PLATFORM_WEB)
+		width = std::min(width, maxWidth);
+		height = std::min(height, maxHeight);
+	#endif
+	camera.zoom = 1;
 
 	InitWindow(width, height, "Maze Solver");
 	SetTargetFPS(60);
@@ -67,7 +99,8 @@ int main(int argc, char **argv)
 		GameLoop();
 	#endif
 
-	free_maze(); // Free memory for maze
+	clear_boxes(); // Stop the search thread
+	unload_drawing();
 	CloseWindow();
 	
 	return 0;
@@ -77,6 +110,8 @@ void GameLoop()
 {
 	Vector2 mousePos = GetMousePosition();
 
+	move_camera(mousePos);
+
 	// No algorithm is running
 	// Allow to place waypoints and start new algorithms
 	if (alg == -1)
@@ -88,60 +123,143 @@ void GameLoop()
 			// 0: Left mouse button, 1: right mouse button
 			if (IsMouseButtonPressed(i))
 			{
+				// Ctrl + left click edits walls instead
+				if (i == 0 && IsKeyDown(KEY_LEFT_CONTROL))
+				{
+					toggle_wall(mousePos);
+					continue;
+				}
+
 				// Get waypoint from mouse position
 				get_waypoint(mousePos, waypoints[i], waypointsPos[i]);
 				waypointsDropped[i] = true;
 				// If sorting occurred previously, clear drawn boxes
 				clear_boxes();
+				planned = false, lastAlg = -1;
+				// A new end point needs a new field, and the agents were going to the old one
+				if (i == 1)
+					fieldVersion = 0, agents.clear();
+			}
+		}
+
+		// F: send agents to the end point
+		if (waypointsDropped[1] && IsKeyPressed(KEY_F))
+			send_agents();
+
+		// Step back through the last search and forward again, or play it again with R
+		if (lastAlg != -1)
+		{
+			if (IsKeyPressed(KEY_LEFT))
+				play_search(-1);
+			else if (IsKeyPressed(KEY_RIGHT))
+				play_search(1);
+			else if (IsKeyPressed(KEY_R))
+			{
+				rewind_search();
+				alg = lastAlg;
+				timer = animTimer = 0;
 			}
 		}
 
 		// If a start and end point has been specified
 		if (waypointsDropped[0] && waypointsDropped[1])
 		{
-			// Number keys 1 - 3
-			for (int i = 0; i < 3; i++)
+			// Number keys 1 - 5
+			for (int i = 0; i < NUM_ALGORITHMS; i++)
 			{
 				if (IsKeyPressed(KEY_ONE + i))
 				{
 					// Reset timers
 					timer = animTimer = 0;
 					// Set to specified algorithm
-					alg = i;
+					alg = lastAlg = i;
+					// It runs to the end on its own thread, the animation catches up
+					start_search(maze, waypointsPos[0], waypointsPos[1], alg);
 					break;
 				}
 			}
 		}
 	}
 
-	// If the algorithm is running
-	// Allow to increase step time
+	// If the algorithm is being shown
+	// Allow to change step time, pause and step by hand
 	else
 	{
 		if (IsKeyPressed(KEY_UP))
 			stepTime_ms += 10;
-		else if (IsKeyPressed(KEY_DOWN) && stepTime_ms > 10)
-				stepTime_ms -= 10;
-
-		float deltaTime = GetFrameTime();
-		// Adding up time since last frame gives the amount of time that has passed
-		timer += deltaTime, animTimer += deltaTime;
-		// This is what gives the pause in visualization
-		if (animTimer >= (stepTime_ms / 1000.0f))
+		else if (IsKeyPressed(KEY_DOWN) && stepTime_ms > 0)
+			stepTime_ms -= 10;
+		if (IsKeyPressed(KEY_SPACE))
+			paused = !paused;
+
+		// As many steps as the time since the last frame has room for
+		long steps = 0;
+		if (!paused)
+		{
+			float deltaTime = GetFrameTime();
+			// Adding up time since last frame gives the amount of time that has passed
+			timer += deltaTime, animTimer += deltaTime;
+			if (stepTime_ms == 0)
+				steps = LONG_MAX, animTimer = 0;
+			else
+			{
+				steps = long(animTimer * 1000 / stepTime_ms);
+				animTimer -= steps * stepTime_ms / 1000.0f;
+			}
+		}
+		// Left and right go a step at a time (paused)
+		if (IsKeyPressed(KEY_RIGHT))
+			steps = 1, paused = true;
+		else if (IsKeyPressed(KEY_LEFT))
+			steps = -1, paused = true;
+
+		// Check if all of the search has been shown
+		if (play_search(steps))
 		{
-			animTimer = 0;
-			// After each run of the search algorithm, check if it has ben completed
-			bool done = find_path(maze, waypointsPos[0], waypointsPos[1], alg);
-			if (done)
-				alg = -1; // False value
-		} 
-	}	
+			// One line of JSON per search, for comparing runs
+			write_json(std::cout, last_result(), alg);
+			std::cout << std::endl;
+			alg = -1; // False value
+			paused = false;
+		}
+	}
+
+	move_agents();
 
 	BeginDrawing();
 
 		ClearBackground(BLACK);
 
-		draw_maze(w, h - 1, blockSize);
+		BeginMode2D(camera);
+
+			draw_maze(*maze, blockSize, camera);
+
+			// Show descriptive boxes and text (for algorithms)
+			draw_box(*maze, blockSize);
+
+			draw_agents(agents, blockSize, camera);
+
+			// Shows user-selected waypoints (on top of everything)
+			if (waypointsDropped[0])
+				DrawCircleV(waypoints[0], blockSize / 3, BLUE);
+			if (waypointsDropped[1])
+				DrawCircleV(waypoints[1], blockSize / 3, GOLD);
+
+		EndMode2D();
+
+		if (path_not_found())
+			DrawText("Path Not Found!", width / 2 - 99, height / 2, 25, RED);
+
+		// Work done by the current (or last) search
+		if (last_result().expanded > 0)
+			display_stats(last_result(), 5, 5);
+
+		if (waypointsDropped[1])
+		{
+			const char *text = agents.empty() ? "F: send agents to [end]"
+				: TextFormat("%zu agents, field built in %.2f ms", agents.size(), fieldMs);
+			DrawText(text, width - MeasureText(text, 15) - 5, 5, 15, GRAY);
+		}
 
 		// Not searching
 		if (alg == -1)
@@ -152,17 +270,21 @@ void GameLoop()
 				DrawText("Left click to place [start].", 5, height - 20, 15, GRAY);
 				DrawText("Right click to place [end].", width - 185, height - 20, 15, GRAY);
 			}
+			else
+				DrawText("Ctrl + left click: add or remove a wall", 5, height - 40, 15, GRAY);
 
 			// When the user has dropped both waypoints, display algorithm choices
 			if (waypointsDropped[0] && waypointsDropped[1])
-				display_options("Depth-First Search;Breadth-First Search;A* Pathfinding",
-					width / (3 + 1), height - 20);
+				display_options("Depth-First Search;Breadth-First Search;A* Pathfinding;Bi-BFS;Bi-A*",
+					width / (NUM_ALGORITHMS + 1), height - 20);
 		}
 
 		// When searching, displaying animation delay
 		else
 		{
 			DrawText(TextFormat("Step Time: %d ms", stepTime_ms), width - 130, height - 20, 15, GRAY);
+			const char *text = paused ? "Paused. Space: play, Left/Right: step" : "Space: pause, Left/Right: step";
+			DrawText(text, width - MeasureText(text, 15) - 5, height - 40, 15, GRAY);
 		}
 
 		// Show timer after user has dropped both waypoints
@@ -170,40 +292,52 @@ void GameLoop()
 		if (waypointsDropped[0] && waypointsDropped[1])
 			DrawText(TextFormat("%.2fs", timer), 5, height- 20, 15, RAYWHITE);
 
-		// Show descriptive boxes and text (for algorithms)
-		draw_box(blockSize);
+	EndDrawing();
+}
 
-		// Shows user-selected waypoints (on top of everything)
-		if (waypointsDropped[0])
-			DrawCircleV(waypoints[0], blockSize / 3, BLUE);
-		if (waypointsDropped[1])
-			DrawCircleV(waypoints[1], blockSize / 3, GOLD);
+// Mouse wheel zooms around the mouse, dragging with the middle button pans
+void move_camera(const Vector2& mousePos)
+{
+	float wheel = GetMouseWheelMove();
+	if (wheel != 0)
+	{
+		// Keep the point under the mouse where it is
+		camera.target = GetScreenToWorld2D(mousePos, camera);
+		camera.offset = mousePos;
 
-	EndDrawing();
+		// Far enough out to see the whole maze (and a bit), in far enough to see one box big
+		float fit = std::min(float(width) / (maze->width() * blockSize), float(height) / (maze->height() * blockSize));
+		float minZoom = std::min(1.0f, fit / 2), maxZoom = 8;
+		camera.zoom = std::max(minZoom, std::min(maxZoom, camera.zoom * std::pow(1.1f, wheel)));
+	}
+
+	if (IsMouseButtonDown(MOUSE_BUTTON_MIDDLE))
+	{
+		Vector2 delta = GetMouseDelta();
+		camera.target.x -= delta.x / camera.zoom;
+		camera.target.y -= delta.y / camera.zoom;
+	}
 }
 
 // Set position of waypoint in world space and in Maze based on mouse position
 // Ensure waypoint is a multiple of [blockSize], i.e., snap it to grid created by the maze
 void get_waypoint(const Vector2& mousePos, Vector2& waypoint, Pos& waypointPos)
 {
-	// Make position multiple of block size
-	waypoint = {std::floorf(mousePos.x / blockSize) * blockSize,
-				std::floorf(mousePos.y / blockSize) * blockSize};
+	// Where the mouse is in the maze, whatever the zoom and pan
+	Vector2 world = GetScreenToWorld2D(mousePos, camera);
+
 	// Get index of position in grid using [blockSize]
-	waypointPos = {static_cast<int>(waypoint.x / blockSize),
-					static_cast<int>(waypoint.y / blockSize)};
-	
+	// Clicks off the maze go to the nearest box on it
+	waypointPos = {static_cast<int>(std::floor(world.x / blockSize)),
+					static_cast<int>(std::floor(world.y / blockSize))};
+	waypointPos.x = std::max(0, std::min(int(maze->width()) - 1, waypointPos.x));
+	waypointPos.y = std::max(0, std::min(int(maze->height()) - 1, waypointPos.y));
+
+	// Make position multiple of block size
 	// Circle is centred at (0, 0), so it'll appear at the top-left
 	// Move it to the right and down by half the block size, so it can be centred in box
-	waypoint.x += (blockSize / 2);
-	waypoint.y += (blockSize / 2);
-
-	// Don't allow placing at below certain point
-	if (waypointPos.y >= height - 1)
-	{
-		waypointPos.y--;
-		waypoint.y -= blockSize;
-	}
+	waypoint = {float(waypointPos.x * blockSize + blockSize / 2),
+				float(waypointPos.y * blockSize + blockSize / 2)};
 }
 
 // Given a string of semicolon-separated phrases
@@ -226,3 +360,107 @@ void display_options(const std::string& options, int w, int h)
 		w += MeasureText(text, 15) + 15;
 	}
 }
+
+// Show the stats of a search in a box at ([x], [y])
+void display_stats(const SearchResult& res, int x, int y)
+{
+	const SearchStats& s = res.stats;
+	const int lines = 7, lineHeight = 16;
+	DrawRectangle(x, y, 190, lines * lineHeight + 8, (Color) {0, 0, 0, 180});
+
+	// TextFormat() only keeps a few strings around, so each is drawn right away
+	x += 5, y += 5;
+	DrawText(TextFormat("Expanded: %zu", res.expanded), x, y, 15, RAYWHITE);
+	DrawText(TextFormat("Pushed: %zu", s.pushed), x, y += lineHeight, 15, RAYWHITE);
+	DrawText(TextFormat("Duplicate pops: %zu", s.duplicatePops), x, y += lineHeight, 15, RAYWHITE);
+	DrawText(TextFormat("Reopened: %zu", s.reopened), x, y += lineHeight, 15, RAYWHITE);
+	DrawText(TextFormat("Peak frontier: %zu", s.peakFrontier), x, y += lineHeight, 15, RAYWHITE);
+	DrawText(TextFormat("Peak memory: %.1f KB", s.peakBytes / 1024.0), x, y += lineHeight, 15, RAYWHITE);
+	DrawText(TextFormat("Compute: %.3f ms", s.ns / 1e6), x, y += lineHeight, 15, RAYWHITE);
+}
+
+// Make [field] point at the end point again if it or the walls changed
+static void update_field()
+{
+	if (fieldVersion == maze->version())
+		return;
+
+	double t0 = GetTime();
+	field.build(*maze, waypointsPos[1]);
+	fieldMs = (GetTime() - t0) * 1000;
+	fieldVersion = maze->version();
+}
+
+// Add agents at random boxes (and the start point), all following one field to the end point
+// The field is only built again once the end point moves or a wall is edited
+void send_agents()
+{
+	update_field();
+
+	static Random random {1};
+	if (waypointsDropped[0])
+		agents.push_back(waypointsPos[0]);
+	for (int i = 0; i < agentsPerPress; i++)
+	{
+		Pos p {int(random.below(maze->width())), int(random.below(maze->height()))};
+		if (field.reaches(p))
+			agents.push_back(p);
+	}
+}
+
+// Every agent takes a step each [stepTime_ms]; the ones that arrived are gone
+void move_agents()
+{
+	if (agents.empty())
+		return;
+
+	agentTimer += GetFrameTime();
+	if (agentTimer < stepTime_ms / 1000.0f)
+		return;
+	agentTimer = 0;
+
+	// Walls were edited: agents walled off from the end point have nowhere to go
+	update_field();
+	for (Pos& a : agents)
+		a = field.next(a);
+	agents.erase(std::remove_if(agents.begin(), agents.end(),
+		[](const Pos& a) { return a == field.goal() || !field.reaches(a); }), agents.end());
+}
+
+// Put up or knock down the wall of the box under the mouse that the mouse is nearest to
+// When both waypoints are down, the path between them is repaired right away
+//  (only the boxes whose distance changed are searched again)
+void toggle_wall(const Vector2& mousePos)
+{
+	Vector2 world = GetScreenToWorld2D(mousePos, camera);
+	Pos box {static_cast<int>(std::floor(world.x / blockSize)),
+			static_cast<int>(std::floor(world.y / blockSize))};
+
+	// Where in the box the mouse is (0 to 1 across), so which side it's nearest to
+	float fx = world.x / blockSize - box.x, fy = world.y / blockSize - box.y;
+	Pos next = box;
+	if (std::min(fx, 1 - fx) < std::min(fy, 1 - fy))
+		next.x += (fx < 0.5f) ? -1 : 1;
+	else
+		next.y += (fy < 0.5f) ? -1 : 1;
+
+	// The search thread may still be reading the maze, so the edit goes to a copy
+	//  that then takes its place (outer walls and clicks off the maze change nothing)
+	Maze edited {*maze};
+	if (!edited.open_path(box, next) && !edited.close_path(box, next))
+		return;
+	maze = std::make_shared<const Maze>(std::move(edited));
+	lastAlg = -1;
+
+	if (!waypointsDropped[0] || !waypointsDropped[1])
+		return;
+	if (planned)
+		planner.wall_changed(maze, box, next);
+	else
+	{
+		planner.reset(maze, waypointsPos[0], waypointsPos[1]);
+		planned = true;
+	}
+
+	show_result(*maze, planner.replan());
+}
@@ -1,53 +1,178 @@
 #include "maze.hpp"
 #include <cassert>
 #include <algorithm>
+#include <atomic>
+#include <climits>
+#include <cstring>
+#include <fstream>
 #include <iostream>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
-// Create specified number of nodes and define edges
-Maze::Maze(size_t col, size_t row) : col(col), row(row)
-{	
-	auto is_valid = [col, row](const Pos& v)
+// A file mapped into memory, unmapped when the last maze using it goes
+struct Maze::Mapping
+{
+	void *base = MAP_FAILED;
+	size_t length = 0;
+
+	~Mapping()
 	{
-		return v.x >= 0 && v.x <= col 
-			&& v.y >= 0 && v.y <= row;
-	};
+		if (base != MAP_FAILED)
+			munmap(base, length);
+	}
+};
+
+void Maze::new_id()
+{
+	// Shared by every maze (on any thread); 0 is left for the empty maze
+	static std::atomic<std::uint32_t> nextId {1};
+	id = nextId.fetch_add(1, std::memory_order_relaxed);
+	edits = 0;
+}
 
-	for (int i = 0; i <= row; i++)
+// Create specified number of nodes and define edges
+Maze::Maze(size_t col, size_t row) : row(row), col(col)
+{
+	new_id();
+	// Every vertex starts connected to its right and bottom neighbour (2 bits each)
+	edges.assign(maze_bytes(col, row), 0xFF);
+	bits = edges.data();
+
+	// Vertices on the right and bottom borders have no neighbour there
+	for (int i = 0; i <= int(row); i++)
+		clear_edge(col, i, RIGHT);
+	for (int j = 0; j <= int(col); j++)
+		clear_edge(j, row, DOWN);
+}
+
+Maze::Maze(const Maze& other) : row(other.row), col(other.col)
+{
+	if (other.bits != nullptr)
+		edges.assign(other.bits, other.bits + maze_bytes(col, row));
+	bits = edges.empty() ? nullptr : edges.data();
+	// A copy can be edited apart from the original, so it can't share its versions
+	if (bits != nullptr)
+		new_id();
+}
+
+Maze::Maze(Maze&& other)
+	: row(other.row), col(other.col), edges(std::move(other.edges)),
+	file(std::move(other.file)), bits(other.bits), id(other.id), edits(other.edits)
+{
+	other.row = other.col = 0;
+	other.bits = nullptr;
+	other.id = other.edits = 0;
+}
+
+Maze& Maze::operator=(const Maze& other)
+{
+	if (this != &other)
+		*this = Maze(other);
+	return *this;
+}
+
+Maze& Maze::operator=(Maze&& other)
+{
+	if (this != &other)
 	{
-		for (int j = 0; j <= col; j++)
-		{
-			// Possible neighbours are vertices
-			const Pos edges[]
-			{
-				{j - 1, i}, // above
-				{j + 1, i}, // below
-				{j, i - 1}, // to the left
-				{j, i + 1} // to the right
-			};
-
-			// Add only valid vertices
-			for (Pos e : edges)
-			{
-				if (is_valid(e))
-					maze[{j, i}].insert(e);
-			}
-		}
+		row = other.row, col = other.col;
+		edges = std::move(other.edges);
+		file = std::move(other.file);
+		bits = other.bits;
+		id = other.id, edits = other.edits;
+		other.row = other.col = 0;
+		other.bits = nullptr;
+		other.id = other.edits = 0;
 	}
+	return *this;
+}
+
+// Fields are written byte by byte, so the file reads the same on any machine
+static void put(unsigned char *at, std::uint64_t value, int bytes)
+{
+	for (int i = 0; i < bytes; i++)
+		at[i] = (unsigned char)(value >> (i * 8));
 }
 
-// Copy values appropriately
-void Maze::operator=(const Maze& other)
+static std::uint64_t get(const unsigned char *at, int bytes)
 {
-	col = other.col, row = other.row;
-	for (int i = 0; i <= row; i++)
+	std::uint64_t value = 0;
+	for (int i = 0; i < bytes; i++)
+		value |= std::uint64_t(at[i]) << (i * 8);
+	return value;
+}
+
+void write_maze_header(std::ostream& out, size_t col, size_t row, const MazeInfo& info)
+{
+	unsigned char header[MAZE_HEADER_SIZE] {};
+	std::memcpy(header, "MAZE", 4);
+	put(header + 4, MAZE_FILE_VERSION, 4);
+	put(header + 8, col, 8);
+	put(header + 16, row, 8);
+	put(header + 24, info.seed, 8);
+	put(header + 32, std::uint32_t(info.generator), 4);
+	put(header + 36, MAZE_HEADER_SIZE, 4);
+	put(header + 40, maze_bytes(col, row), 8);
+	out.write((const char*)header, sizeof(header));
+}
+
+bool Maze::save(const std::string& path, const MazeInfo& info) const
+{
+	// No walls to write (empty or moved from), and a header alone would be a truncated file
+	if (bits == nullptr)
+		return false;
+	std::ofstream out {path, std::ios::binary | std::ios::trunc};
+	if (!out)
+		return false;
+
+	write_maze_header(out, col, row, info);
+	out.write((const char*)bits, maze_bytes(col, row));
+	return bool(out.flush());
+}
+
+bool Maze::load(const std::string& path, MazeInfo *info)
+{
+	int fd = open(path.c_str(), O_RDONLY);
+	if (fd == -1)
+		return false;
+
+	struct stat st {};
+	auto mapping = std::make_shared<Mapping>();
+	if (fstat(fd, &st) == 0 && size_t(st.st_size) >= MAZE_HEADER_SIZE)
 	{
-		for (int j = 0; j <= col; j++)
-		{
-			Pos p = {j, i};
-			if (other.is_vertex(p))
-				maze[p] = other.maze.at(p);
-		}
+		mapping->length = size_t(st.st_size);
+		// Private and writable: pages are shared until someone writes to them
+		mapping->base = mmap(nullptr, mapping->length, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+	}
+	// The mapping stays valid without the descriptor
+	close(fd);
+	if (mapping->base == MAP_FAILED)
+		return false;
+
+	const unsigned char *header = (const unsigned char*)mapping->base;
+	size_t w = get(header + 8, 8), h = get(header + 16, 8);
+	size_t offset = get(header + 36, 4), bytes = get(header + 40, 8);
+	// Boxes are addressed with ints, so bigger sizes can only be a broken file
+	if (std::memcmp(header, "MAZE", 4) != 0 || get(header + 4, 4) != MAZE_FILE_VERSION
+		|| w > INT_MAX || h > INT_MAX || bytes != maze_bytes(w, h)
+		|| offset < MAZE_HEADER_SIZE || offset > mapping->length || mapping->length - offset < bytes)
+		return false;
+
+	if (info != nullptr)
+	{
+		info->seed = get(header + 24, 8);
+		info->generator = int(std::int32_t(get(header + 32, 4)));
 	}
+
+	col = w, row = h;
+	edges.clear();
+	edges.shrink_to_fit();
+	bits = (std::uint8_t*)mapping->base + offset;
+	file = mapping;
+	new_id();
+	return true;
 }
 
 // Print out [Pos] nicely
@@ -59,24 +184,36 @@ std::ostream& operator<<(std::ostream& out, const Pos& pos)
 
 bool Maze::is_vertex(const Pos& vertex) const
 {
-	return maze.find(vertex) != maze.end();
+	return vertex.x >= 0 && vertex.x <= int(col)
+		&& vertex.y >= 0 && vertex.y <= int(row);
 }
 
-/* .at() is used for const objects, because operator[] has
-	no const definition 
-*/
+// An edge between two neighbouring vertices is stored in the left or top one of them
+bool Maze::owner(const Pos& one, const Pos& two, Pos& vertex, std::uint8_t& bit) const
+{
+	if (!is_vertex(one) || !is_vertex(two))
+		return false;
+
+	if (one.y == two.y && std::abs(one.x - two.x) == 1)
+		bit = RIGHT;
+	else if (one.x == two.x && std::abs(one.y - two.y) == 1)
+		bit = DOWN;
+	else
+		return false;
+
+	vertex = {std::min(one.x, two.x), std::min(one.y, two.y)};
+	return true;
+}
 
 bool Maze::is_wall(const Pos& vertex, const Pos& wall) const
 {
-	return (is_vertex(vertex) &&
-		maze.at(vertex).find(wall) != maze.at(vertex).end());
+	Pos v; std::uint8_t bit;
+	return owner(vertex, wall, v, bit) && has_edge(v.x, v.y, bit);
 }
 
 size_t Maze::num_of_neighbours(const Pos& vertex) const
 {
-	if (is_vertex(vertex))
-		return maze.at(vertex).size();
-	return 0;
+	return walls(vertex).size();
 }
 
 // Returning neighbours
@@ -85,8 +222,19 @@ std::vector<Pos> Maze::walls(const Pos& vertex) const
 	std::vector<Pos> verts {};
 	if (is_vertex(vertex))
 	{
-		for (auto n : maze.at(vertex))
-			verts.push_back(n);
+		const Pos edges[]
+		{
+			{vertex.x - 1, vertex.y}, // to the left
+			{vertex.x + 1, vertex.y}, // to the right
+			{vertex.x, vertex.y - 1}, // above
+			{vertex.x, vertex.y + 1} // below
+		};
+
+		for (Pos e : edges)
+		{
+			if (is_wall(vertex, e))
+				verts.push_back(e);
+		}
 	}
 
 	return verts;
@@ -109,74 +257,123 @@ std::vector<Pos> Maze::walls(const Pos& vertex) const
 				- not connected to it's top neighbour, then we can move right
 				- not connected to it's left neighbour, then we can move down
 */
-std::vector<Pos> Maze::paths(const Pos& vertex) const
+Neighbours Maze::paths(const Pos& vertex) const
 {
-	std::vector<Pos> openPaths {};
-
-	// Right and bottom neighbours
-	Pos vertexRight = {vertex.x + 1, vertex.y},
-		vertexDown = {vertex.x, vertex.y + 1};
-	// Right bottom neighbour
-	Pos oppVertex = {vertex.x + 1, vertex.y + 1};
+	Neighbours openPaths {};
 
-	// If all of them are not neighbours, then this guy is isolated
-	if (!is_vertex(vertex) || !is_vertex(vertexRight)
-		|| !is_vertex(vertexDown) || !is_vertex(oppVertex))
+	// Only vertices with a right, bottom and bottom-right neighbour are the
+	//  top-left corner of a box; everyone else is isolated
+	if (vertex.x < 0 || vertex.y < 0
+		|| vertex.x >= int(col) || vertex.y >= int(row))
 		return openPaths;
 
+	const int x = vertex.x, y = vertex.y;
+
 	// If the vertex is not connected to it's right neighbour, then we can move up
-	if (!is_wall(vertex, vertexRight))
-	{
-		Pos vertexUp = {vertex.x, vertex.y - 1};
-		if (is_vertex(vertexUp))
-			openPaths.push_back(vertexUp);
-	}
+	if (y > 0 && !has_edge(x, y, RIGHT))
+		openPaths.push_back({x, y - 1});
 
 	// If the opposite vertex is not connected to it's left neighbour,
 	// 	i.e, the current vertex's bottom neighbour, then we can move down
-	if (!is_wall(oppVertex, vertexDown))
-	{
-		if (is_vertex(vertexDown))
-			openPaths.push_back(vertexDown);
-	}
+	// We don't want extreme-end paths, i.e, paths that are outside the screen
+	if (y + 1 < int(row) && !has_edge(x, y + 1, RIGHT))
+		openPaths.push_back({x, y + 1});
 
 	// If the vertex is not connected to it's bottom neighbour, then we can move left
-	if (!is_wall(vertex, vertexDown))
-	{
-		Pos vertexLeft = {vertex.x - 1, vertex.y};
-		if (is_vertex(vertexLeft))
-			openPaths.push_back(vertexLeft);
-	}
+	if (x > 0 && !has_edge(x, y, DOWN))
+		openPaths.push_back({x - 1, y});
 
 	// If the opposite vertex is not connected to it's top neighbour,
 	// 	i.e, the current vertex's right neighbour, then we can move right
-	if (!is_wall(oppVertex, vertexRight))
-	{
-		if (is_vertex(vertexRight))
-			openPaths.push_back(vertexRight);
-	}
-
-	// We don't want extreme-end paths, i.e, paths that are outside the screen
-	openPaths.erase(std::remove_if(
-		openPaths.begin(), openPaths.end(),
-		[this](Pos p){ return p.x >= this->width() || p.y >= this->height(); }
-	), openPaths.end());
+	if (x + 1 < int(col) && !has_edge(x + 1, y, DOWN))
+		openPaths.push_back({x + 1, y});
 
 	return openPaths;
 }
 
+// Same bits paths() looks at, a row at a time
+void Maze::row_passages(int y, std::uint64_t *right, std::uint64_t *down) const
+{
+	const size_t words = (col + 63) / 64;
+	std::fill(right, right + words, 0);
+	std::fill(down, down + words, 0);
+	if (y < 0 || y >= int(row))
+		return;
+
+	for (int x = 0; x < int(col); x++)
+	{
+		std::uint64_t bit = std::uint64_t(1) << (x & 63);
+		if (x + 1 < int(col) && !has_edge(x + 1, y, DOWN))
+			right[x >> 6] |= bit;
+		if (y + 1 < int(row) && !has_edge(x, y + 1, RIGHT))
+			down[x >> 6] |= bit;
+	}
+}
+
 // Returns true if wall is successfully removed
 bool Maze::remove_wall(const Pos& vertex, const Pos& wall)
 {
-	if (is_wall(vertex, wall))
+	Pos v; std::uint8_t bit;
+	if (owner(vertex, wall, v, bit) && has_edge(v.x, v.y, bit))
 	{
-		// Erase both ways (since it's an undirected graph)
-		maze[vertex].erase(wall);
-		if (is_wall(wall, vertex))
-			maze[wall].erase(vertex);
+		// One bit covers both ways (since it's an undirected graph)
+		clear_edge(v.x, v.y, bit);
+		edited();
+		return true;
+	}
+
+	return false;
+}
+
+// Returns true if wall is successfully put back
+bool Maze::add_wall(const Pos& vertex, const Pos& wall)
+{
+	Pos v; std::uint8_t bit;
+	if (owner(vertex, wall, v, bit) && !has_edge(v.x, v.y, bit))
+	{
+		set_edge(v.x, v.y, bit);
+		edited();
+		return true;
+	}
+
+	return false;
+}
 
+bool Maze::wall_between(const Pos& box, const Pos& next, Pos& one, Pos& two) const
+{
+	auto is_box = [this](const Pos& p)
+		{ return p.x >= 0 && p.y >= 0 && p.x < int(col) && p.y < int(row); };
+	if (!is_box(box) || !is_box(next))
+		return false;
+
+	// Side by side: the wall is the vertical edge on their shared side
+	if (box.y == next.y && std::abs(box.x - next.x) == 1)
+	{
+		int x = std::max(box.x, next.x);
+		one = {x, box.y}, two = {x, box.y + 1};
+		return true;
+	}
+	// One above the other: the wall is the horizontal edge between them
+	if (box.x == next.x && std::abs(box.y - next.y) == 1)
+	{
+		int y = std::max(box.y, next.y);
+		one = {box.x, y}, two = {box.x + 1, y};
 		return true;
 	}
 
 	return false;
 }
+
+// Returns true if the wall between the boxes is successfully removed
+bool Maze::open_path(const Pos& box, const Pos& next)
+{
+	Pos one, two;
+	return wall_between(box, next, one, two) && remove_wall(one, two);
+}
+
+// Returns true if the boxes had no wall between them and now do
+bool Maze::close_path(const Pos& box, const Pos& next)
+{
+	Pos one, two;
+	return wall_between(box, next, one, two) && add_wall(one, two);
+}
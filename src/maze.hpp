@@ -2,11 +2,11 @@
 #ifndef MAZE_H_
 #define MAZE_H_
 
-#include <unordered_map>
-#include <unordered_set>
 #include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
 #include <vector>
-#include "raylib.h"
 #include <ostream>
 #include <cmath>
 
@@ -48,27 +48,127 @@ namespace std
 	};
 }
 
+// Up to four neighbouring boxes, kept in place so listing them never allocates
+struct Neighbours
+{
+	Pos boxes[4];
+	int count = 0;
+
+	void push_back(const Pos& p) { boxes[count++] = p; }
+	const Pos *begin() const { return boxes; }
+	const Pos *end() const { return boxes + count; }
+	size_t size() const { return size_t(count); }
+	bool empty() const { return count == 0; }
+	const Pos& operator[](size_t i) const { return boxes[i]; }
+};
+
+// What a maze file knows about the maze in it, besides its size
+struct MazeInfo
+{
+	std::uint64_t seed = 0;
+	int generator = -1; // [MazeAlgorithm] it was made with (-1 if unknown)
+};
+
+// Maze file
+/*
+	A 64-byte header followed by the edge bits exactly as [Maze] keeps them,
+		so loading is only a matter of mapping the file into memory.
+	Header (little-endian):
+		0	"MAZE"
+		4	u32 version
+		8	u64 width
+		16	u64 height
+		24	u64 seed
+		32	i32 generator
+		36	u32 header size (64)
+		40	u64 bytes of edge bits that follow
+		48	zeros
+*/
+constexpr std::uint32_t MAZE_FILE_VERSION = 1;
+constexpr size_t MAZE_HEADER_SIZE = 64;
+// Bytes of edge bits of a [col] x [row] maze
+inline size_t maze_bytes(size_t col, size_t row) { return ((col + 1) * (row + 1) + 3) / 4; }
+void write_maze_header(std::ostream&, size_t col, size_t row, const MazeInfo&);
+
 class Maze
 {
 private:
 	size_t row = 0, col = 0;
-	// Graph as adjacency list
-	std::unordered_map<Pos, std::unordered_set<Pos>> maze {};
+	// Graph as a row-major grid of (col + 1) * (row + 1) vertices.
+	// Each vertex only owns the edges to its right and bottom neighbours,
+	//  so two bits are enough; four vertices are packed into a byte
+	std::vector<std::uint8_t> edges {};
+
+	// A loaded maze keeps its bits in the mapped file instead of [edges]
+	struct Mapping;
+	std::shared_ptr<Mapping> file {};
+	// Points into [edges] or [file]
+	std::uint8_t *bits = nullptr;
+
+	// What version() is made of: a number no other maze has (taken when the maze is
+	//  made, copied or loaded) and how many edits it has had since
+	std::uint32_t id = 0, edits = 0;
+	void new_id();
+	void edited() { if (++edits == 0) new_id(); }
+
+	// Bits for the two edges a vertex owns
+	enum : std::uint8_t { RIGHT = 1, DOWN = 2 };
+
+	size_t index(int x, int y) const { return size_t(y) * (col + 1) + size_t(x); }
+	bool has_edge(int x, int y, std::uint8_t bit) const
+		{ size_t i = index(x, y); return (bits[i >> 2] >> ((i & 3) << 1)) & bit; }
+	void clear_edge(int x, int y, std::uint8_t bit)
+		{ size_t i = index(x, y); bits[i >> 2] &= ~(bit << ((i & 3) << 1)); }
+	void set_edge(int x, int y, std::uint8_t bit)
+		{ size_t i = index(x, y); bits[i >> 2] |= bit << ((i & 3) << 1); }
+	// The wall between two neighbouring boxes, as the two vertices at its ends
+	bool wall_between(const Pos&, const Pos&, Pos&, Pos&) const;
+	// Find which vertex owns the edge between two vertices (and which bit it is)
+	bool owner(const Pos&, const Pos&, Pos&, std::uint8_t&) const;
 
 public:
 	Maze() = default;
 	Maze(size_t, size_t);
+	// A copy always gets bits of its own, even when [other] is a mapped file
+	Maze(const Maze& other);
+	Maze(Maze&& other);
+	Maze& operator=(const Maze& other);
+	Maze& operator=(Maze&& other);
 
-	// Assignment operator
-	void operator=(const Maze&);
+	// Write the maze to [path] (the header and then all the bits in one go)
+	// Returns false, without touching [path], for a maze with no walls (empty or moved from)
+	bool save(const std::string& path, const MazeInfo& info = MazeInfo {}) const;
+	// Replace this maze with the one saved at [path]
+	/*
+		The file is mapped copy-on-write instead of read, so opening is instant,
+			processes loading the same file share the pages in the page cache,
+			and removing walls only copies the pages that change (never the file).
+		Returns false (and leaves the maze alone) if the file is missing or not a maze file.
+	*/
+	bool load(const std::string& path, MazeInfo *info = nullptr);
+	bool is_mapped() const { return file != nullptr; }
+
+	// Changes whenever a wall does, and two different mazes never have the same one,
+	//  so anything worked out from a maze is still right as long as the version is
+	std::uint64_t version() const { return (std::uint64_t(id) << 32) | edits; }
 
 	// Remove edge connecting two vertices (both ways)
 	bool remove_wall(const Pos&, const Pos&);
+	// Remove the wall between two neighbouring boxes (the opposite of paths())
+	bool open_path(const Pos&, const Pos&);
+	// Put back an edge between two vertices
+	bool add_wall(const Pos&, const Pos&);
+	// Put back the wall between two neighbouring boxes
+	bool close_path(const Pos&, const Pos&);
 	
 	// Return list of neighbours
 	std::vector<Pos> walls(const Pos&) const;
 	// Return neighbouring vertices that are not blocked off by walls
-	std::vector<Pos> paths(const Pos&) const;
+	Neighbours paths(const Pos&) const;
+
+	// Open passages out of the boxes of row [y] as bit masks (bit x % 64 of word x / 64):
+	//  [right] to (x + 1, y) and [down] to (x, y + 1); each needs (width + 63) / 64 words
+	void row_passages(int y, std::uint64_t *right, std::uint64_t *down) const;
 
 	bool is_vertex(const Pos&) const;
 	bool is_wall(const Pos&, const Pos&) const; 
@@ -78,4 +178,14 @@ public:
 	size_t num_of_neighbours(const Pos& vertex) const;
 };
 
+// A maze that nobody changes any more, shared by everyone reading it
+/*
+	Handing one on copies a pointer, not the walls, so the drawing, the search thread
+		and whatever is built from the maze all read the same bits.
+	An edit goes to a copy, which then takes the old one's place (copy-on-write):
+		whoever still holds the old one keeps reading it while the new one is made,
+		and it's freed once the last of them lets go.
+*/
+typedef std::shared_ptr<const Maze> MazeSnapshot;
+
 #endif
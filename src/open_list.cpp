@@ -0,0 +1,158 @@
+#include "open_list.hpp"
+#include <algorithm>
+
+void BoxDeque::grow()
+{
+	// Unwrap into the new buffer, so the front is at 0 again
+	std::vector<int> bigger(std::max<size_t>(16, ring.size() * 2));
+	for (size_t i = 0; i < count; i++)
+		bigger[i] = ring[(head + i) & mask()];
+	ring.swap(bigger);
+	head = 0;
+}
+
+void BucketQueue::clear(TieBreak tie)
+{
+	// Only the buckets that were used have anything in them
+	for (size_t i = 0; i < used; i++)
+	{
+		buckets[i].clear();
+		heads[i] = 0;
+	}
+	lowest = count = used = 0;
+	newestFirst = (tie == TieBreak::LARGER_G);
+}
+
+void BucketQueue::push(int box, int f)
+{
+	size_t i = size_t(std::max(f, 0));
+	if (i >= buckets.size())
+	{
+		buckets.resize(i + 1);
+		heads.resize(i + 1, 0);
+	}
+	used = std::max(used, i + 1);
+
+	size_t before = buckets[i].capacity();
+	buckets[i].push_back(box);
+	storage += buckets[i].capacity() - before;
+	lowest = std::min(lowest, i);
+	count++;
+}
+
+int BucketQueue::pop(int& f)
+{
+	while (heads[lowest] == buckets[lowest].size())
+		lowest++;
+
+	std::vector<int>& bucket = buckets[lowest];
+	int box;
+	if (newestFirst)
+	{
+		box = bucket.back();
+		bucket.pop_back();
+	}
+	else
+		box = bucket[heads[lowest]++];
+
+	// Emptied, so its space can be used from the start again
+	if (heads[lowest] == bucket.size())
+	{
+		bucket.clear();
+		heads[lowest] = 0;
+	}
+
+	count--;
+	f = int(lowest);
+	return box;
+}
+
+size_t BucketQueue::bytes() const
+{
+	return buckets.capacity() * sizeof(std::vector<int>) + heads.capacity() * sizeof(size_t)
+		+ storage * sizeof(int);
+}
+
+void IndexedHeap::clear(size_t boxes, TieBreak tie)
+{
+	// Popped boxes were taken out of [where] already
+	for (const Entry& e : heap)
+		where[e.box] = -1;
+	heap.clear();
+	if (where.size() != boxes)
+		where.assign(boxes, -1);
+	this->tie = tie;
+}
+
+bool IndexedHeap::before(const Entry& a, const Entry& b) const
+{
+	if (a.f != b.f)
+		return a.f < b.f;
+	return (tie == TieBreak::LARGER_G) ? a.g > b.g : a.g < b.g;
+}
+
+void IndexedHeap::place(size_t i, const Entry& e)
+{
+	heap[i] = e;
+	where[e.box] = int(i);
+}
+
+void IndexedHeap::up(size_t i)
+{
+	Entry e = heap[i];
+	while (i > 0 && before(e, heap[(i - 1) / 2]))
+	{
+		place(i, heap[(i - 1) / 2]);
+		i = (i - 1) / 2;
+	}
+	place(i, e);
+}
+
+void IndexedHeap::down(size_t i)
+{
+	Entry e = heap[i];
+	while (true)
+	{
+		size_t child = i * 2 + 1;
+		if (child >= heap.size())
+			break;
+		if (child + 1 < heap.size() && before(heap[child + 1], heap[child]))
+			child++;
+		if (!before(heap[child], e))
+			break;
+		place(i, heap[child]);
+		i = child;
+	}
+	place(i, e);
+}
+
+void IndexedHeap::push(int box, int f, int g)
+{
+	if (where[box] == -1)
+	{
+		heap.push_back({box, f, g});
+		up(heap.size() - 1);
+		return;
+	}
+
+	// Already in; it can only have got cheaper
+	size_t i = size_t(where[box]);
+	heap[i].f = f, heap[i].g = g;
+	up(i);
+}
+
+int IndexedHeap::pop(int& f)
+{
+	Entry top = heap.front();
+	where[top.box] = -1;
+	f = top.f;
+
+	Entry last = heap.back();
+	heap.pop_back();
+	if (!heap.empty())
+	{
+		place(0, last);
+		down(0);
+	}
+	return top.box;
+}
@@ -0,0 +1,128 @@
+#ifndef OPEN_LIST_H_
+#define OPEN_LIST_H_
+
+#include <cstddef>
+#include <vector>
+
+// Which of two open boxes with the same cost A* takes first
+// Larger g (closer to the goal) usually means fewer boxes are explored
+enum class TieBreak : unsigned char { LARGER_G, SMALLER_G };
+
+// Open lists for A* (boxes are numbered y * width + x)
+enum class OpenList : unsigned char { BUCKET, HEAP };
+
+// Frontier of DFS and BFS: a double-ended queue of boxes in one ring buffer
+/*
+	DFS pushes to the front (a stack) and BFS to the back (a queue), both pop the front.
+	The buffer doubles when it's full and clear() keeps it,
+		so a reused search stops allocating once it has seen its biggest frontier.
+*/
+class BoxDeque
+{
+private:
+	std::vector<int> ring {}; // Size is 0 or a power of two
+	size_t head = 0, count = 0;
+
+	void grow();
+	size_t mask() const { return ring.size() - 1; }
+
+public:
+	void clear() { head = count = 0; }
+	void push_front(int box)
+	{
+		if (count == ring.size())
+			grow();
+		head = (head - 1) & mask();
+		ring[head] = box;
+		count++;
+	}
+	void push_back(int box)
+	{
+		if (count == ring.size())
+			grow();
+		ring[(head + count) & mask()] = box;
+		count++;
+	}
+	int front() const { return ring[head]; }
+	int pop_front()
+	{
+		int box = ring[head];
+		head = (head + 1) & mask();
+		count--;
+		return box;
+	}
+
+	bool empty() const { return count == 0; }
+	size_t size() const { return count; }
+	size_t bytes() const { return ring.capacity() * sizeof(int); }
+};
+
+// Dial's bucket queue
+/*
+	Costs are small whole numbers (steps + Manhattan distance), so there is
+		one bucket per cost and the cheapest box is found by walking up from
+		the lowest bucket that's not empty: O(1) per push and pop.
+	With a consistent heuristic the lowest cost never goes down, so the walk
+		never goes back.
+
+	Boxes are not moved when they get cheaper; a new entry is pushed and the old one
+		is left for A* to skip (it can tell from its own costs).
+	Within a bucket LARGER_G pops the newest entry (the children of the box explored last,
+		which are the deepest), SMALLER_G the oldest. It's the usual cheap stand-in
+		for comparing g, not an exact order.
+*/
+class BucketQueue
+{
+private:
+	std::vector<std::vector<int>> buckets {};
+	// Where the oldest entry of each bucket is (for SMALLER_G)
+	std::vector<size_t> heads {};
+	size_t lowest = 0, count = 0, used = 0;
+	// Sum of the capacities of [buckets], kept as they grow (so bytes() doesn't go through them)
+	size_t storage = 0;
+	bool newestFirst = true;
+
+public:
+	void clear(TieBreak);
+	void push(int box, int f);
+	// Takes a box with the lowest cost, which goes in [f]
+	int pop(int& f);
+
+	bool empty() const { return count == 0; }
+	size_t size() const { return count; }
+	size_t bytes() const;
+};
+
+// Binary heap that knows where every box is in it
+/*
+	A box that gets cheaper is moved up where it is (decrease-key),
+		so every box is in the heap at most once and nothing goes stale.
+	Ties are broken exactly by g.
+*/
+class IndexedHeap
+{
+private:
+	struct Entry { int box, f, g; };
+	std::vector<Entry> heap {};
+	// Position of each box in [heap] (-1 if not in it)
+	std::vector<int> where {};
+	TieBreak tie = TieBreak::LARGER_G;
+
+	bool before(const Entry&, const Entry&) const;
+	void place(size_t i, const Entry&);
+	void up(size_t i);
+	void down(size_t i);
+
+public:
+	// Only the boxes still in the heap are forgotten, not all [boxes]
+	void clear(size_t boxes, TieBreak);
+	// Add [box], or lower its cost if it's already in
+	void push(int box, int f, int g);
+	int pop(int& f);
+
+	bool empty() const { return heap.empty(); }
+	size_t size() const { return heap.size(); }
+	size_t bytes() const { return heap.capacity() * sizeof(Entry) + where.capacity() * sizeof(int); }
+};
+
+#endif
@@ -0,0 +1,196 @@
+#include "path_cache.hpp"
+#include <algorithm>
+#include <chrono>
+
+size_t PathCache::KeyHash::operator()(const Key& k) const
+{
+	// Mix each part in (boost's hash_combine)
+	size_t h = std::hash<std::uint64_t>()(k.version);
+	for (size_t v : {size_t(k.start.x), size_t(k.start.y), size_t(k.end.x), size_t(k.end.y), size_t(k.alg)})
+		h ^= v + 0x9e3779b97f4a7c15 + (h << 6) + (h >> 2);
+	return h;
+}
+
+// Same order as Maze::paths
+static const Pos moves[4] {{0, -1}, {0, 1}, {-1, 0}, {1, 0}};
+
+static int step_of(const Pos& from, const Pos& to)
+{
+	if (to.y < from.y)
+		return 0;
+	if (to.y > from.y)
+		return 1;
+	return (to.x < from.x) ? 2 : 3;
+}
+
+static Pos take_step(const Pos& p, int step)
+{
+	return {p.x + moves[step].x, p.y + moves[step].y};
+}
+
+static int step_at(const std::vector<std::uint8_t>& steps, size_t i)
+{
+	return (steps[i >> 2] >> ((i & 3) << 1)) & 3;
+}
+
+void PathCache::unpack(const Entry& e, size_t from, size_t to, std::vector<Pos>& out)
+{
+	// Walk from the start of the path to [from], then on to [to]
+	const size_t lo = std::min(from, to), hi = std::max(from, to);
+	Pos p = e.key.start;
+	for (size_t i = 0; i < lo; i++)
+		p = take_step(p, step_at(e.steps, i));
+
+	out.clear();
+	out.reserve(hi - lo + 1);
+	out.push_back(p);
+	for (size_t i = lo; i < hi; i++)
+	{
+		p = take_step(p, step_at(e.steps, i));
+		out.push_back(p);
+	}
+	if (from > to)
+		std::reverse(out.begin(), out.end());
+}
+
+bool PathCache::locate(const Entry& e, const Pos& a, const Pos& b, size_t& ia, size_t& ib)
+{
+	auto inside = [&](const Pos& p)
+		{ return p.x >= e.low.x && p.y >= e.low.y && p.x <= e.high.x && p.y <= e.high.y; };
+	if (!e.found || !inside(a) || !inside(b))
+		return false;
+
+	// A path never goes through a box twice, so the first match is the only one
+	bool seenA = false, seenB = false;
+	Pos p = e.key.start;
+	for (size_t i = 0; ; i++)
+	{
+		if (!seenA && p == a)
+			ia = i, seenA = true;
+		if (!seenB && p == b)
+			ib = i, seenB = true;
+		if ((seenA && seenB) || i + 1 >= e.length)
+			break;
+		p = take_step(p, step_at(e.steps, i));
+	}
+	return seenA && seenB;
+}
+
+bool PathCache::find(const Maze& maze, Pos start, Pos end, int alg, SearchResult& res)
+{
+	auto t0 = std::chrono::steady_clock::now();
+	const std::uint64_t version = maze.version();
+
+	// Exactly these ends, or the same ends the other way round
+	bool found = false;
+	std::list<Entry>::iterator it {};
+	size_t from = 0, to = 0;
+	auto exact = index.find({start, end, alg, version});
+	auto backwards = index.find({end, start, alg, version});
+	if (exact != index.end())
+	{
+		it = exact->second, found = true;
+		from = 0, to = it->length ? it->length - 1 : 0;
+	}
+	else if (backwards != index.end())
+	{
+		it = backwards->second, found = true;
+		from = it->length ? it->length - 1 : 0, to = 0;
+	}
+
+	if (found)
+		hits++;
+	// Part of a recent path that goes through both
+	else
+	{
+		size_t looked = 0;
+		for (it = entries.begin(); it != entries.end() && looked < SUB_PATH_SCAN; ++it, looked++)
+		{
+			if (it->key.alg == alg && it->key.version == version && locate(*it, start, end, from, to))
+			{
+				found = true;
+				subHits++;
+				break;
+			}
+		}
+	}
+
+	if (!found)
+	{
+		misses++;
+		return false;
+	}
+
+	// Used again, so it's the most recent now
+	entries.splice(entries.begin(), entries, it);
+
+	res = SearchResult {};
+	res.found = it->found;
+	if (res.found)
+	{
+		unpack(*it, from, to, res.path);
+		res.pathLength = res.path.size();
+	}
+	res.stats.ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+		std::chrono::steady_clock::now() - t0).count();
+	return true;
+}
+
+void PathCache::insert(const Maze& maze, Pos start, Pos end, int alg, const SearchResult& res)
+{
+	if (capacity == 0)
+		return;
+
+	const Key key {start, end, alg, maze.version()};
+	auto known = index.find(key);
+	if (known != index.end())
+	{
+		entries.erase(known->second);
+		index.erase(known);
+	}
+	// Make room
+	while (entries.size() >= capacity)
+	{
+		index.erase(entries.back().key);
+		entries.pop_back();
+	}
+
+	Entry e {};
+	e.key = key;
+	e.found = res.found;
+	e.length = res.path.size();
+	e.low = e.high = start;
+	if (res.found && !res.path.empty())
+	{
+		e.steps.assign((e.length + 2) / 4, 0);
+		for (size_t i = 0; i < e.length; i++)
+		{
+			const Pos& p = res.path[i];
+			e.low = {std::min(e.low.x, p.x), std::min(e.low.y, p.y)};
+			e.high = {std::max(e.high.x, p.x), std::max(e.high.y, p.y)};
+			if (i + 1 < e.length)
+				e.steps[i >> 2] |= std::uint8_t(step_of(p, res.path[i + 1]) << ((i & 3) << 1));
+		}
+	}
+
+	entries.push_front(std::move(e));
+	index[key] = entries.begin();
+}
+
+SearchResult PathCache::solve(const Maze& maze, Pos start, Pos end, int alg)
+{
+	SearchResult res {};
+	if (find(maze, start, end, alg, res))
+		return res;
+
+	res = ::solve(maze, start, end, alg);
+	insert(maze, start, end, alg, res);
+	return res;
+}
+
+void PathCache::clear()
+{
+	entries.clear();
+	index.clear();
+	hits = subHits = misses = 0;
+}
@@ -0,0 +1,82 @@
+#ifndef PATH_CACHE_H_
+#define PATH_CACHE_H_
+
+#include "maze.hpp"
+#include "solver.hpp"
+#include <cstdint>
+#include <list>
+#include <unordered_map>
+#include <vector>
+
+// Paths found before, for queries that come up again
+/*
+	Keyed by the two ends, the algorithm and the maze's version(), so once a wall
+		changes nothing from before it is used again (it just ages out).
+	Holds at most [capacity] paths and drops the least recently used one to make room.
+
+	Besides asking for the same ends again, a query is answered from a path
+		that goes through both of its ends, in either direction:
+		any part of a path is a path, and any part of a shortest path is a shortest path.
+		Only the [SUB_PATH_SCAN] most recently used paths are looked through for that,
+		so a miss costs the same however many paths are kept.
+
+	Paths are kept as their first box and a 2-bit step per box after it.
+*/
+class PathCache
+{
+private:
+	struct Key
+	{
+		Pos start, end;
+		int alg;
+		std::uint64_t version;
+
+		bool operator==(const Key& o) const
+			{ return start == o.start && end == o.end && alg == o.alg && version == o.version; }
+	};
+	struct KeyHash
+	{
+		size_t operator()(const Key& k) const;
+	};
+
+	struct Entry
+	{
+		Key key;
+		bool found = false;
+		size_t length = 0; // Boxes on the path
+		std::vector<std::uint8_t> steps {}; // 4 steps per byte: up, down, left, right
+		Pos low, high; // Corners of the rectangle the path stays in
+	};
+
+	enum : size_t { SUB_PATH_SCAN = 8 };
+
+	size_t capacity;
+	// Most recently used first
+	std::list<Entry> entries {};
+	std::unordered_map<Key, std::list<Entry>::iterator, KeyHash> index {};
+	size_t hits = 0, subHits = 0, misses = 0;
+
+	// Boxes [from] to [to] of an entry's path (backwards if [from] is past [to])
+	static void unpack(const Entry&, size_t from, size_t to, std::vector<Pos>& out);
+	// Where [a] and [b] are along an entry's path; false unless both are on it
+	static bool locate(const Entry&, const Pos& a, const Pos& b, size_t& ia, size_t& ib);
+
+public:
+	explicit PathCache(size_t capacity = 256) : capacity(capacity) {}
+
+	// A path for the query from what's kept, if there is one (then it goes in [res])
+	bool find(const Maze&, Pos start, Pos end, int algIndex, SearchResult& res);
+	// Keep a search's result
+	void insert(const Maze&, Pos start, Pos end, int algIndex, const SearchResult&);
+	// find(), or search and insert() when it's not there
+	SearchResult solve(const Maze&, Pos start, Pos end, int algIndex);
+
+	void clear();
+	size_t size() const { return entries.size(); }
+	// Queries answered with a whole kept path, with part of one, and not at all
+	size_t num_hits() const { return hits; }
+	size_t num_sub_hits() const { return subHits; }
+	size_t num_misses() const { return misses; }
+};
+
+#endif
@@ -0,0 +1,108 @@
+#include "replay.hpp"
+#include <algorithm>
+
+void Replay::reset(int c, int row)
+{
+	col = c;
+	events.clear();
+	before.clear();
+	state.assign(size_t(c) * row, Box::NONE);
+	pos = explored = pushed = 0;
+	changed.clear();
+	replaced = true;
+}
+
+void Replay::append(const std::vector<TraceEvent>& more)
+{
+	events.insert(events.end(), more.begin(), more.end());
+	before.resize(events.size(), Box::NONE);
+}
+
+void Replay::set(int box, Box s)
+{
+	state[box] = s;
+	if (replaced)
+		return;
+	// Once more changed than there are boxes, redrawing them all is cheaper
+	if (changed.size() >= state.size())
+		changed.clear(), replaced = true;
+	else
+		changed.push_back({box % col, box / col});
+}
+
+void Replay::play()
+{
+	const TraceEvent e = events[pos++];
+	if (e.is_wipe())
+	{
+		std::fill(state.begin(), state.end(), Box::NONE);
+		changed.clear();
+		replaced = true;
+		return;
+	}
+	explored += explores(e);
+	pushed += pushes(e);
+	before[pos - 1] = state[e.box()];
+	set(e.box(), e.state());
+}
+
+void Replay::undo()
+{
+	const TraceEvent e = events[--pos];
+	if (e.is_wipe())
+	{
+		replay_to(pos);
+		return;
+	}
+	explored -= explores(e);
+	pushed -= pushes(e);
+	set(e.box(), before[pos]);
+}
+
+void Replay::replay_to(size_t to)
+{
+	std::fill(state.begin(), state.end(), Box::NONE);
+	pos = explored = pushed = 0;
+	changed.clear();
+	replaced = true;
+	while (pos < to)
+		play();
+}
+
+void Replay::step(long steps)
+{
+	// A step starts with the box it explores, so stop right before the next one
+	for (long taken = 0; steps > 0 && pos < events.size(); )
+	{
+		if (explores(events[pos]) && taken++ == steps)
+			break;
+		play();
+	}
+	for (long taken = 0; steps < 0 && pos > 0 && taken < -steps; )
+	{
+		undo();
+		taken += explores(events[pos]);
+	}
+}
+
+void Replay::to_end()
+{
+	while (pos < events.size())
+		play();
+}
+
+Box Replay::box_state(const Pos& p) const
+{
+	if (p.x < 0 || p.y < 0 || p.x >= col || size_t(p.y) * col + p.x >= state.size())
+		return Box::NONE;
+	return state[size_t(p.y) * col + p.x];
+}
+
+bool Replay::take_changes(std::vector<Pos>& out)
+{
+	out.clear();
+	out.swap(changed);
+	bool same = !replaced;
+	replaced = false;
+	return same;
+}
@@ -0,0 +1,65 @@
+#ifndef REPLAY_H_
+#define REPLAY_H_
+
+#include "trace.hpp"
+#include <vector>
+
+// Plays back the events of a search (see trace.hpp), forwards or backwards
+/*
+	Every event is kept, so the animation can go anywhere in the search at any speed,
+		while the search itself ran at full speed long before.
+	A step is what the search did in one go: explore a box and push its neighbours,
+		so moving by steps looks just like the search stepping.
+
+	Going back undoes events one at a time: each remembers what its box showed before
+		(worked out when it's played). Only a wipe can't be undone like that,
+		so going back past one plays everything up to it again.
+*/
+class Replay
+{
+private:
+	int col = 0;
+	std::vector<TraceEvent> events {};
+	std::vector<Box> before {}; // What the box of each event showed before it (once played)
+	std::vector<Box> state {}; // What every box shows at [pos]
+	size_t pos = 0; // Events played
+	size_t explored = 0, pushed = 0; // Boxes explored and pushed by then
+
+	// Boxes whose state changed since take_changes(), unless they all did
+	std::vector<Pos> changed {};
+	bool replaced = true;
+
+	static bool explores(TraceEvent e)
+		{ return !e.is_wipe() && (e.state() == Box::EXPLORED || e.state() == Box::BACK_EXPLORED); }
+	static bool pushes(TraceEvent e)
+		{ return !e.is_wipe() && (e.state() == Box::FRONTIER || e.state() == Box::BACK_FRONTIER); }
+	void set(int box, Box s);
+	void play();
+	void undo();
+	// Blank everything and play the first [to] events again
+	void replay_to(size_t to);
+
+public:
+	// Nothing recorded yet, for a maze of [col] x [row] boxes
+	void reset(int col, int row);
+	// Record events (after the ones recorded before)
+	void append(const std::vector<TraceEvent>&);
+
+	// Move [steps] steps forwards, or back if negative (only as far as has been recorded)
+	void step(long steps);
+	void to_start() { replay_to(0); }
+	void to_end();
+
+	size_t position() const { return pos; }
+	size_t size() const { return events.size(); }
+	bool at_end() const { return pos == events.size(); }
+	size_t num_explored() const { return explored; }
+	size_t num_pushed() const { return pushed; }
+
+	Box box_state(const Pos&) const;
+	// Moves the boxes that changed into [out]
+	// Returns false if every box may have changed (drawing should start over)
+	bool take_changes(std::vector<Pos>& out);
+};
+
+#endif
@@ -1,195 +1,325 @@
 #include "solver.hpp"
-#include "raylib.h"
+#include "replay.hpp"
 #include <iostream>
-#include <unordered_set>
-#include <unordered_map>
-#include <list> // linked list
-#include <queue> // prority_queue
+#include <algorithm>
+#include <chrono>
 
-extern int width, height;
+SearchContext::SearchContext(const Maze& maze, Pos start, Pos end, int alg, bool visualise)
+	: maze(maze), start(start), end(end), alg(alg), visualise(visualise)
+{
+	reset(start, end, alg);
+}
 
-enum Algorithm : int { DFS = 0, BFS, A_STAR };
+// Resize [v] to [n] entries of [value], only when the maze size has changed
+template <typename T>
+static void fit(std::vector<T>& v, size_t n, T value)
+{
+	if (v.size() != n)
+		v.assign(n, value);
+}
 
-// Holds the total cost and distance to goal (for A*)
-typedef std::pair<int, int> Cost_Dist;
-// Item in priority queue (for A*)
-typedef std::pair<Pos, Cost_Dist> A_Pos;
+void SearchContext::next_epoch()
+{
+	// Stamps that were never written are 0, so every epoch starts at 2 or more
+	if (epoch > UINT32_MAX - 4)
+	{
+		std::fill(stamp.begin(), stamp.end(), 0);
+		for (Side& side : sides)
+			std::fill(side.stamp.begin(), side.stamp.end(), 0);
+		epoch = 0;
+	}
+	epoch += 2;
+}
 
-// static here means only declare in one file
+void SearchContext::wipe_boxes()
+{
+	if (boxEpoch == UINT32_MAX)
+	{
+		std::fill(boxStamp.begin(), boxStamp.end(), 0);
+		boxEpoch = 0;
+	}
+	boxEpoch++;
+	changed.clear();
+	boxesReplaced = true;
+	if (trace != nullptr)
+		trace->put(TraceEvent::wipe());
+}
 
-// Depth- and breadth-first search algorithms are in one function
-//  cause they differ by only one line
-static bool dfs_bfs(bool, const Maze&, Pos,
-	std::unordered_set<Pos>&, std::list<Pos>&,
-	std::unordered_map<Pos, Pos>&);
-// Helper function to backtrack shortest path for end to start
-static void show_path(const Maze&, Pos, Pos, const std::unordered_map<Pos, Pos>&);
+void SearchContext::reset(Pos start, Pos end, int alg)
+{
+	this->start = start, this->end = end, this->alg = alg;
+	searching = true;
+
+	// Everything keeps its memory for the next search
+	const size_t n = maze.width() * maze.height();
+	next_epoch();
+	container.clear();
+	buckets.clear(tieBreak);
+	// The heap only gets its per-box array once it is used (or has boxes left from before)
+	if (openList == OpenList::HEAP || !heap.empty())
+		heap.clear(n, tieBreak);
+	if (visualise)
+	{
+		fit(boxes, n, Box::NONE);
+		fit(boxStamp, n, std::uint32_t(0));
+	}
+	wipe_boxes();
+	res.found = false;
+	res.pathLength = res.expanded = 0;
+	res.path.clear();
+	res.stats = SearchStats {};
 
-// A* algorithm
-template <typename C>
-static bool a_star(const Maze&, Pos,
-	std::unordered_set<Pos>&,
-	std::priority_queue<A_Pos, std::vector<A_Pos>, C>&,
-	std::unordered_map<Pos, Cost_Dist>&,
-	std::unordered_map<Pos, Pos>&);
+	turn = 0;
+	best = -1;
 
-/*
-	Each search function performs only a step of the entire task.
-	The state of the function is preserved in static variables, so
-	it can continue from where it stopped when called again.
+	// Nothing to search from or for outside the maze
+	const bool inside = in_maze(start) && in_maze(end);
 
-	This allows the search to be non-blocking.
-*/
+	// Bidirectional searches start one side at each end
+	if (alg == BI_BFS || alg == BI_A_STAR)
+	{
+		const Pos from[2] {start, end};
+		for (int i = 0; i < 2; i++)
+		{
+			Side& side = sides[i];
+			side.queue.clear();
+			side.open.clear();
+			fit(side.stamp, n, std::uint32_t(0));
+			fit(side.g, n, 0);
+			fit(side.parent, n, 0);
+			// Only the counts the last search used can be left over
+			if (side.atG.size() != size_t(n) + 1)
+				side.atG.assign(size_t(n) + 1, 0);
+			else
+				std::fill(side.atG.begin(), side.atG.begin() + side.gTop + 1, 0);
+			side.gMin = side.gTop = 0;
+			side.to = from[1 - i];
+			if (!inside)
+				continue;
+
+			int b = box_index(from[i]);
+			side.stamp[b] = epoch, side.g[b] = 0, side.parent[b] = b;
+			if (alg == BI_BFS)
+				side.queue.push_back(b);
+			else
+				side.open.push({from[i], {from[i].distance(side.to), 0}}), side.atG[0] = 1;
+		}
 
-static bool searching = false, path404 = false;
+		// Nothing to search for
+		if (inside && start == end)
+			best = 0, meet[0] = meet[1] = start;
+		return;
+	}
 
-// Stores colour of box for each [Pos]
-static std::unordered_map<Pos, Color> boxes {};
-static std::unordered_map<Pos, Cost_Dist> a_star_texts {};
+	fit(stamp, n, std::uint32_t(0));
+	fit(parentBox, n, 0);
+	if (!inside)
+		return;
+	int s = box_index(start);
+	stamp[s] = epoch, parentBox[s] = s;
 
-static Color MINT = (Color) {99, 163, 117, 255};
+	// Put starting node in correct container
+	if (alg != A_STAR)
+	{
+		container.push_back(s);
+		return;
+	}
 
-// Comparator for priority queue,
-// which returns true when the first guy has a higher cost than the second
-// Creates a min-heap priority queue
-static auto a_compare = [](const A_Pos& one, const A_Pos& two)
-	{ return one.second.first > two.second.first; };
+	// For A*, we also need to initialize the cost of [start]
+	fit(gCost, n, 0);
+	gCost[s] = 0;
+	if (openList == OpenList::HEAP)
+		heap.push(s, start.distance(end), 0);
+	else
+		buckets.push(s, start.distance(end));
+}
 
-bool find_path(const Maze& maze, Pos start, Pos end, int alg)
+bool SearchContext::step(size_t steps)
 {
-	// static here means they last for the lifetime of the program
-	
-	// Stores already explored nodes
-	static std::unordered_set<Pos> visited;
-	// Frontier for DFS and BFS (used a linked list cause it can act as a stack and queue)
-	static std::list<Pos> container;
-	// Spanning tree for retrieving shortest path
-	static std::unordered_map<Pos, Pos> searchTree;
-	// A* data structures
-	// Priority queue which returns lowest cost element first
-	static std::priority_queue<A_Pos, std::vector<A_Pos>, decltype(a_compare)> a_container (a_compare);
-	static std::unordered_map<Pos, Cost_Dist> costs;
-
-	// If this function is called and [searching is false], then we are to set up things for searching
 	if (!searching)
-	{
-		searching = true;
-		clear_boxes();
-
-		// Put starting node in correct container
-		if (alg != A_STAR)
-			container.push_back(start);
-		else
-		{
-			// For A*, we also need to initialize the cost of [start]
-			costs[start] = {start.distance(end), 0};
-			a_container.push({start, costs[start]});
-		}
+		return true;
+
+	auto t0 = std::chrono::steady_clock::now();
+	bool done = false;
+	for (size_t i = 0; i < steps && !done; i++)
+		done = advance();
+	res.stats.ns += std::chrono::duration_cast<std::chrono::nanoseconds>(
+		std::chrono::steady_clock::now() - t0).count();
+	return done;
+}
 
-		searchTree[start] = start;
-	}
+bool SearchContext::advance()
+{
+	if (!searching)
+		return true;
 
 	// Call algorithm based on index
 	switch (alg)
 	{
 		case DFS: case BFS:
-			searching = dfs_bfs(alg == DFS, maze, end, visited, container, searchTree);
+			searching = dfs_bfs(alg == DFS);
 			break;
 
 		case A_STAR:
-		 	searching = a_star(maze, end, visited, a_container, costs, searchTree);
+		 	searching = a_star();
+			break;
+
+		case BI_BFS: case BI_A_STAR:
+			searching = bidirectional(alg == BI_A_STAR);
 			break;
 		
 		// Unknown algorithm
 		default:
 			std::cerr << "solver.cpp: error: Unkown algorithm\n";
 			searching = false;
-			return false;
+			return true;
 	}
+	// Containers only grow during a search, so their memory is only added up at the end,
+	//  unless something is watching every step (the animation takes [changed] away too)
+	if (visualise)
+		update_peaks();
+	else
+		update_frontier();
 
-	// If searching has ended, clear variables
+	// If searching has ended, only the path is left to show
 	if (!searching)
 	{
-		visited.clear();
-		boxes.clear();
-
-		if (alg != A_STAR)
-			container.clear();
-		else
-		{
-			// Priority queue doesn't have clear() function
-			while (!a_container.empty())
-				a_container.pop();
-			costs.clear();
-		}
+		wipe_boxes();
 
 		// Draw out shortest path
-		show_path(maze, start, end, searchTree);
-		searchTree.clear();
+		if (alg == BI_BFS || alg == BI_A_STAR)
+			show_meeting_path();
+		else
+			show_path();
+		update_peaks();
 	}
 
 	return !searching;
 }
 
+// Timed once for the whole search rather than every step
+const SearchResult& SearchContext::run()
+{
+	auto t0 = std::chrono::steady_clock::now();
+	while (!advance());
+	res.stats.ns += std::chrono::duration_cast<std::chrono::nanoseconds>(
+		std::chrono::steady_clock::now() - t0).count();
+	return res;
+}
+
+// Bytes held by a vector
+template <typename T>
+static size_t vector_bytes(const std::vector<T>& v) { return v.capacity() * sizeof(T); }
+
+void SearchContext::update_frontier()
+{
+	size_t frontier = 0;
+	switch (alg)
+	{
+		case DFS: case BFS:
+			frontier = container.size();
+			break;
+		case A_STAR:
+			frontier = (openList == OpenList::HEAP) ? heap.size() : buckets.size();
+			break;
+		default:
+			frontier = sides[0].queue.size() + sides[0].open.size() + sides[1].queue.size() + sides[1].open.size();
+	}
+	res.stats.peakFrontier = std::max(res.stats.peakFrontier, frontier);
+}
+
+void SearchContext::update_peaks()
+{
+	size_t frontier = container.size() + buckets.size() + heap.size();
+	size_t bytes = vector_bytes(stamp) + vector_bytes(gCost) + vector_bytes(parentBox)
+		+ container.bytes() + buckets.bytes() + heap.bytes()
+		+ vector_bytes(boxes) + vector_bytes(boxStamp) + vector_bytes(changed);
+	for (const Side& side : sides)
+	{
+		frontier += side.queue.size() + side.open.size();
+		bytes += side.queue.bytes() + side.open.capacity() * sizeof(A_Pos)
+			+ vector_bytes(side.stamp) + vector_bytes(side.g) + vector_bytes(side.parent)
+			+ vector_bytes(side.atG);
+	}
+
+	res.stats.peakFrontier = std::max(res.stats.peakFrontier, frontier);
+	res.stats.peakBytes = std::max(res.stats.peakBytes, bytes);
+}
+
+SearchResult solve(const Maze& maze, Pos start, Pos end, int alg, OpenList list, TieBreak tie)
+{
+	SearchContext search {maze, start, end, alg};
+	if (alg == A_STAR && (list != OpenList::BUCKET || tie != TieBreak::LARGER_G))
+	{
+		search.set_open_list(list, tie);
+		search.reset(start, end, alg);
+	}
+	return search.run();
+}
+
 // DFS and BFS algorithms
 /*
 	We are traversing the graph, while making sure to avoid
-		already [visited] nodes.
-	The preceding vertex used to get to the next vertex is stored in [searchTree].
+		already visited (closed) nodes.
+	The preceding vertex used to get to the next vertex is stored in [parentBox].
 	The difference between BFS and DFS is the use of the [container].
 	In BFS, we use a queue, so vertex that were added first are explored first,
 		while in DFS, we explored the last added vertex, so we go deep inside a
 		specific path.
 	When the goal is reached or they are no more vertices to explore, we stop
 */
-static bool dfs_bfs(
-	bool dfs,
-	const Maze& maze,
-	Pos goal,
-	std::unordered_set<Pos>& visited,
-	std::list<Pos>& container,
-	std::unordered_map<Pos, Pos>& searchTree)
+bool SearchContext::dfs_bfs(bool dfs)
 {
-	// No path found
-	if (container.empty())
-		return false;
+	int curr;
+	// If we've visited this node before,
+	//  i.e, it was added again by another vertex before it was explored
+	// We want to skip it, but for the visualization to be seamless, we go to the next vertex
+	while (true)
+	{
+		// No path found
+		if (container.empty())
+			return false;
 
-	// Get next vertex (current)
-	Pos curr = container.front();
-	container.pop_front();
+		// Get next vertex (current)
+		curr = container.pop_front();
 
-	// We've found the goal
-	if (curr == goal)
-		return false;
+		// We've found the goal
+		if (box_pos(curr) == end)
+			return false;
 
-	// If we've visited this node before,
-	//  i.e, it was added again by another vertex before it was explored
-	if (visited.find(curr) != visited.end())
-	 	// We want to skip it, but for the visualization to be seamless, we go to the next vertex
-		return dfs_bfs(dfs, maze, goal, visited, container, searchTree);
-	else
-		visited.insert(curr);
+		if (!closed(stamp, curr))
+			break;
+		res.stats.duplicatePops++;
+	}
+	stamp[curr] = epoch + 1;
+	Pos currPos = box_pos(curr);
 
 	// Explored gets green
-	boxes[curr] = MINT;
+	if (visualise)
+		mark(currPos, Box::EXPLORED);
+	res.expanded++;
 	// Go through possible paths
-	for (Pos next : maze.paths(curr))
+	for (Pos next : maze.paths(currPos))
 	{
+		int i = box_index(next);
 		// If you haven't been visited
-		if (visited.find(next) == visited.end())
+		if (!closed(stamp, i))
 		{
 			// Stack
 			if (dfs)
-				container.push_front(next);
+				container.push_front(i);
 			// Queue
 			else
-				container.push_back(next);
+				container.push_back(i);
 
 			// Save parent
-			searchTree[next] = curr;
+			stamp[i] = epoch;
+			parentBox[i] = curr;
+			res.stats.pushed++;
 
 			// Unvisited gets light gray
-			boxes[next] = LIGHTGRAY;
+			if (visualise)
+				mark(next, Box::FRONTIER);
 		}
 	}
 	
@@ -206,119 +336,415 @@ static bool dfs_bfs(
 	This allows the algorithm to make smart choices on which vertex to explore next.
 	
 	Starting from the starting vertex, we take a look at all its neighbours.
-	If a neighbour has not been visited, the cost which is
+	If a neighbour has not been reached, the cost which is
 		the distance from the start to the this node + the estimated distance to the goal
-		is computed (the distance from the starting vertex and cost is saved in [costs]).
-	If a neighbour has already been visited, we check if the path from the current node
-		to it is cheaper than what is already in the queue.
-	We then add the neighbour to the priority queue if satisfies any condition above.
+		is computed (the distance from the start is saved in [gCost]).
+	If a neighbour has already been reached, we check if the path from the current node
+		to it is cheaper than the one it has.
+	We then add the neighbour to the open list if satisfies any condition above.
 
-	The priority queue returns the cheapest node. Because going back is more expensive 
-		than going forward, we don't need to check if a node has been visited when exploring
-		(it automatically avoids cycle cause it knows if something is in the queue and ignores it
-		if it's more expensive).
-	However, a node can be visited twice, if a cheaper path is found through it.
+	The open list returns the cheapest node (see open_list.hpp). Because the Manhattan distance
+		never overestimates and never drops by more than a step, a node is already
+		as cheap as it gets when it comes out, so it is closed and never looked at again.
 
 	We continue this until, we reach the goal or nothing else is left.
 
-	A spanning tree ([searchTree]) is used to backtrack to get the shortest path.
+	Every node remembers which node it was reached from ([parentBox]) to get the shortest path.
 */
-template <typename C>
-static bool a_star(
-	const Maze& maze,
-	Pos goal,
-	std::unordered_set<Pos>& visited,
-	std::priority_queue<A_Pos, std::vector<A_Pos>, C>& container,
-	std::unordered_map<Pos, Cost_Dist>& costs,
-	std::unordered_map<Pos, Pos>& searchTree)
+bool SearchContext::a_star()
 {
-	// No path found
-	if (container.empty())
-		return false;
-
-	// Get least expensive element from priority queue
-	A_Pos curr = container.top();
-	container.pop();
+	int curr, f;
+	// Bucket entries are left behind when a node gets cheaper, skip those
+	while (true)
+	{
+		// No path found
+		if (openList == OpenList::HEAP ? heap.empty() : buckets.empty())
+			return false;
 
-	// Element returned from queue is {[Pos], {cost, "distance from start"}}
-	Pos currPos = curr.first;
-	int distFromStart = curr.second.second;
+		curr = (openList == OpenList::HEAP) ? heap.pop(f) : buckets.pop(f);
+		if (!closed(stamp, curr) && gCost[curr] + box_pos(curr).distance(end) == f)
+			break;
+		res.stats.duplicatePops++;
+	}
 
 	// Explored
-	visited.insert(currPos);
+	stamp[curr] = epoch + 1;
+	Pos currPos = box_pos(curr);
 
 	// Goal is reached!
-	if (currPos == goal)
+	if (currPos == end)
 		return false;
 
 	// Colour
-	boxes[currPos] = MINT;
-	a_star_texts[currPos] = curr.second;
+	if (visualise)
+		mark(currPos, Box::EXPLORED);
+	res.expanded++;
 	// Check open paths
 	for (Pos next : maze.paths(currPos))
 	{
-		// Avoid already seen guys (it'll be more expensive anyway)
-		if (visited.find(next) != visited.end())
+		int i = box_index(next);
+		// Avoid already explored guys (they can't get any cheaper)
+		if (closed(stamp, i))
 			continue;
 
 		// Since it's an unweighted graph, the distance to move from one node to another is 1
-		int g = distFromStart + 1;
-		// Check if current node is in priority queue
-		// (everyone in the queue has their cost set)
-		bool inContainer = (costs.find(next) != costs.end());
-		// If node is not in queue
-		if (!inContainer
-			// Or it is, but it's cheaper through this node
-			//  (i.e, it is closer to the start)
-			|| (inContainer && g < costs[next].second))
-		{
-			// Save the cost and distance to start [g]
-			costs[next] = {next.distance(goal) + g, g};
-			// Add to queue
-			container.push({next, costs[next]});
+		int g = gCost[curr] + 1;
+		// Only if it's new, or cheaper through this node
+		bool known = reached(stamp, i);
+		if (known && g >= gCost[i])
+			continue;
 
-			// Save parent
-			searchTree[next] = currPos;
+		res.stats.reopened += known;
+		stamp[i] = epoch;
+		gCost[i] = g;
+		// Save parent
+		parentBox[i] = curr;
 
-			boxes[next] = LIGHTGRAY;
-			a_star_texts[next] = costs[next];
-		}
+		int cost = next.distance(end) + g;
+		if (openList == OpenList::HEAP)
+			heap.push(i, cost, g);
+		else
+			buckets.push(i, cost);
+		res.stats.pushed++;
+
+		if (visualise)
+			mark(next, Box::FRONTIER);
 	}
 
 	// Still searching
 	return true;
 }
 
-static void show_path(const Maze& maze, Pos start, Pos end, const std::unordered_map<Pos, Pos>& searchTree)
+void SearchContext::show_path()
 {
-	if (searchTree.find(end) == searchTree.end())
+	// DFS and BFS stop when the end comes out of the frontier, so it's enough that it was reached
+	if (!in_maze(end) || !reached(stamp, box_index(end)))
+		return;
+
+	int i = box_index(end);
+	for (; parentBox[i] != i; i = parentBox[i])
+		res.path.push_back(box_pos(i));
+	res.path.push_back(box_pos(i));
+
+	res.found = true;
+	std::reverse(res.path.begin(), res.path.end());
+	res.pathLength = res.path.size();
+
+	if (visualise)
+	{
+		for (Pos p : res.path)
+			mark(p, Box::PATH);
+	}
+}
+
+// Bidirectional BFS and A*
+/*
+	Two searches run at the same time, one from the start and one from the end,
+		each exploring a box in turn. Each one only has to cover about half
+		the distance, so together they look at fewer boxes.
+	BFS explores from the side with the smaller frontier.
+	A* goes by max(f(x), 2 g(x)) instead of f(x) (the MM algorithm, "meet in the middle"),
+		from whichever side has the cheaper box: neither side goes further than half the
+		shortest path, where plain f(x) would have each side run most of a whole A*.
+		With the Manhattan distance a box still comes out at its shortest g(x).
+
+	Whenever a side looks at a neighbour the other side has already reached,
+		the two halves make a path; the shortest of those is kept in [best].
+	Meeting is not the end though, a shorter path may still pass elsewhere.
+	We can only stop once no box left in either frontier can lead to
+		something shorter than [best]. A shorter path would have to leave the boxes
+		the start's side explored at some box of its frontier, g(f) or more steps out,
+		and get to one of the end's side, g(b) or more steps from the end, at least a step
+		further on (if they were next to each other, the one explored second would
+		have seen the other), so it's at least g(f) + g(b) + 1 long:
+		- BFS: the boxes at the front of the queues have the lowest g of each side
+		- A*: the lowest g in each open list is kept by counting the boxes at every g.
+			The lower of the two cheapest costs is a bound as well (shown for MM),
+			and a box whose g(x) + h(x) is already [best] isn't pushed at all
+*/
+bool SearchContext::bidirectional(bool aStar)
+{
+	if (aStar)
+	{
+		// Skip entries that a cheaper path replaced
+		for (Side& s : sides)
+		{
+			while (!s.open.empty() && closed(s.stamp, box_index(s.open.top().first)))
+				s.open.pop(), res.stats.duplicatePops++;
+		}
+	}
+
+	// No path found
+	if (aStar ? (sides[0].open.empty() || sides[1].open.empty())
+		: (sides[0].queue.empty() || sides[1].queue.empty()))
+		return false;
+
+	if (best >= 0)
+	{
+		if (!aStar && best <= sides[0].g[sides[0].queue.front()] + sides[1].g[sides[1].queue.front()] + 1)
+			return false;
+		if (aStar)
+		{
+			// Every box left in an open list is counted at its g
+			for (Side& s : sides)
+			{
+				while (s.atG[s.gMin] == 0)
+					s.gMin++;
+			}
+			if (best <= sides[0].gMin + sides[1].gMin + 1
+				|| best <= std::min(sides[0].open.top().second.first, sides[1].open.top().second.first))
+				return false;
+		}
+	}
+
+	// BFS: the smaller frontier goes next
+	// A*: the side with the cheaper box, or the smaller frontier when they cost the same
+	if (aStar)
 	{
-		path404 = true;
+		const int cost0 = sides[0].open.top().second.first, cost1 = sides[1].open.top().second.first;
+		turn = (cost0 != cost1) ? (cost0 < cost1 ? 0 : 1) : (sides[0].open.size() <= sides[1].open.size() ? 0 : 1);
+	}
+	else
+		turn = (sides[0].queue.size() <= sides[1].queue.size()) ? 0 : 1;
+	Side& side = sides[turn];
+	Side& other = sides[1 - turn];
+
+	int curr;
+	if (!aStar)
+		curr = side.queue.pop_front();
+	else
+	{
+		curr = box_index(side.open.top().first);
+		side.open.pop();
+		side.atG[side.g[curr]]--;
+	}
+	int g = side.g[curr];
+	side.stamp[curr] = epoch + 1;
+	Pos currPos = box_pos(curr);
+
+	// Colour
+	if (visualise)
+		mark(currPos, (turn == 0) ? Box::EXPLORED : Box::BACK_EXPLORED);
+	res.expanded++;
+
+	for (Pos next : maze.paths(currPos))
+	{
+		int i = box_index(next);
+		// The other side has been here, so there is a path through this step
+		if (reached(other.stamp, i))
+		{
+			int length = g + 1 + other.g[i];
+			if (best < 0 || length < best)
+			{
+				best = length;
+				meet[turn] = currPos, meet[1 - turn] = next;
+			}
+		}
+
+		if (closed(side.stamp, i))
+			continue;
+
+		bool known = reached(side.stamp, i);
+		// BFS reaches everyone first by the shortest way
+		// A* only goes again if it's cheaper, and not if it can't beat [best] anyway
+		if (known && (!aStar || g + 1 >= side.g[i]))
+			continue;
+		if (aStar && best >= 0 && g + 1 + next.distance(side.to) >= best)
+			continue;
+
+		if (aStar)
+		{
+			// Counted at its new g from now on (its old entry is skipped when it comes out)
+			if (known)
+				side.atG[side.g[i]]--;
+			side.atG[g + 1]++;
+			side.gTop = std::max(side.gTop, g + 1);
+		}
+		side.stamp[i] = epoch;
+		side.g[i] = g + 1;
+		side.parent[i] = curr;
+		res.stats.pushed++;
+		res.stats.reopened += known;
+		// MM's priority, max(f, 2g)
+		if (aStar)
+			side.open.push({next, {std::max(next.distance(side.to) + g + 1, 2 * (g + 1)), g + 1}});
+		else
+			side.queue.push_back(i);
+
+		if (visualise && box_state(next) == Box::NONE)
+			mark(next, (turn == 0) ? Box::FRONTIER : Box::BACK_FRONTIER);
+	}
+
+	return true;
+}
+
+// Join the two halves of a bidirectional search where they met
+void SearchContext::show_meeting_path()
+{
+	if (best < 0)
 		return;
+
+	res.found = true;
+	// Start to the meeting point (backwards)
+	int i = box_index(meet[0]);
+	for (; sides[0].parent[i] != i; i = sides[0].parent[i])
+		res.path.push_back(box_pos(i));
+	res.path.push_back(box_pos(i));
+	std::reverse(res.path.begin(), res.path.end());
+
+	// Meeting point to the end (they are the same box only when start is end)
+	if (meet[1] != meet[0])
+	{
+		i = box_index(meet[1]);
+		for (; sides[1].parent[i] != i; i = sides[1].parent[i])
+			res.path.push_back(box_pos(i));
+		res.path.push_back(box_pos(i));
 	}
+	res.pathLength = res.path.size();
 
-	Pos move = end;
-	while (move != start)
+	if (visualise)
 	{
-		// Light green
-		boxes[move] = (Color) {122, 229, 130, 255};
-		move = searchTree.at(move);
+		for (Pos p : res.path)
+			mark(p, Box::PATH);
 	}
-	boxes[start] = (Color) {122, 229, 130, 255};
+}
+
+const char *algorithm_name(int alg)
+{
+	static const char *names[] = {"dfs", "bfs", "astar", "bibfs", "biastar"};
+	return (alg >= 0 && alg < NUM_ALGORITHMS) ? names[alg] : "unknown";
+}
+
+void write_json(std::ostream& out, const SearchResult& res, int alg)
+{
+	const SearchStats& s = res.stats;
+	out << "{\"alg\": \"" << algorithm_name(alg) << "\", \"found\": " << (res.found ? "true" : "false")
+		<< ", \"path\": " << res.pathLength << ", \"expanded\": " << res.expanded
+		<< ", \"pushed\": " << s.pushed << ", \"duplicate_pops\": " << s.duplicatePops
+		<< ", \"reopened\": " << s.reopened << ", \"peak_frontier\": " << s.peakFrontier
+		<< ", \"peak_bytes\": " << s.peakBytes << ", \"ns\": " << s.ns << "}";
+}
+
+// The animation's search runs on [worker] and [replay] keeps everything it showed
+static SearchWorker worker {};
+static Replay replay {};
+static std::vector<TraceEvent> incoming {};
+// A path from show_result() instead of a search, when [external] is set
+static SearchResult shown {};
+static bool external = false;
 
+void SearchContext::mark(const Pos& box, Box state)
+{
+	int i = box_index(box);
+	boxes[i] = state, boxStamp[i] = boxEpoch;
+	if (trace != nullptr)
+		trace->put(TraceEvent {i, state});
+	else
+		changed.push_back(box);
 }
 
-void draw_box(int boxSize)
+Box SearchContext::box_state(const Pos& box) const
 {
-	for (auto& box : boxes)
-		DrawRectangle(box.first.x * boxSize, box.first.y * boxSize, boxSize, boxSize, box.second);
+	if (!visualise || !in_maze(box) || boxStamp[box_index(box)] != boxEpoch)
+		return Box::NONE;
+	return boxes[box_index(box)];
+}
 
-	if (path404)
-		DrawText("Path Not Found!", width / 2 - 99, height / 2, 25, RED);
+Cost_Dist SearchContext::a_star_text(const Pos& box) const
+{
+	if (alg != A_STAR || !in_maze(box) || !reached(stamp, box_index(box)))
+		return {-1, -1};
+	int g = gCost[box_index(box)];
+	return {g + box.distance(end), g};
+}
+
+bool SearchContext::take_changes(std::vector<Pos>& out)
+{
+	out.clear();
+	out.swap(changed);
+	bool same = !boxesReplaced;
+	boxesReplaced = false;
+	return same;
+}
+
+void start_search(const MazeSnapshot& maze, Pos start, Pos end, int alg)
+{
+	replay.reset(int(maze->width()), int(maze->height()));
+	worker.start(maze, start, end, alg);
+	external = false;
+}
+
+// Whole search shown, up to the last event
+static bool search_finished()
+{
+	return (external || worker.done()) && replay.at_end();
+}
+
+bool play_search(long steps)
+{
+	if (worker.running())
+	{
+		incoming.clear();
+		worker.drain(incoming);
+		replay.append(incoming);
+	}
+	replay.step(steps);
+	return search_finished();
+}
+
+void rewind_search()
+{
+	replay.to_start();
+}
+
+void show_result(const Maze& maze, const SearchResult& res)
+{
+	worker.stop();
+	replay.reset(int(maze.width()), int(maze.height()));
+	incoming.clear();
+	for (const Pos& p : res.path)
+		incoming.push_back({p.y * int(maze.width()) + p.x, Box::PATH});
+	replay.append(incoming);
+	replay.to_end();
+	shown = res;
+	external = true;
+}
+
+Box search_box(const Pos& box)
+{
+	return replay.box_state(box);
+}
+
+bool path_not_found()
+{
+	return search_finished() && !last_result().found;
+}
+
+const SearchResult& last_result()
+{
+	static const SearchResult none {};
+	if (external)
+		return shown;
+	if (!worker.done() && !worker.running())
+		return none;
+	if (search_finished())
+		return worker.result();
+
+	// Part way through: only what the animation has got to
+	static SearchResult progress {};
+	progress.expanded = replay.num_explored();
+	progress.stats.pushed = replay.num_pushed();
+	return progress;
+}
+
+bool box_changes(std::vector<Pos>& changed)
+{
+	return replay.take_changes(changed);
 }
 
 void clear_boxes()
 {
-	boxes.clear();
-	path404 = false;
+	worker.stop();
+	replay.reset(0, 0);
+	external = false;
 }
@@ -1,5 +1,223 @@
+#ifndef SOLVER_H_
+#define SOLVER_H_
+
 #include "maze.hpp"
+#include "open_list.hpp"
+#include <cstdint>
+#include <queue> // prority_queue
+#include <ostream>
+#include <vector>
+
+enum Algorithm : int { DFS = 0, BFS, A_STAR, BI_BFS, BI_A_STAR, NUM_ALGORITHMS };
+
+// What the step-wise search has done to a box (coloured by draw.cpp)
+// Bidirectional searches mark what the search from the end does with BACK_*
+enum class Box : unsigned char { FRONTIER, EXPLORED, PATH, BACK_FRONTIER, BACK_EXPLORED, NONE };
+
+class TraceWriter;
+
+// Holds the total cost and distance to goal (for A*)
+typedef std::pair<int, int> Cost_Dist;
+// Item in priority queue (for A*)
+typedef std::pair<Pos, Cost_Dist> A_Pos;
+
+// Comparator for priority queue,
+// which returns true when the first guy has a higher cost than the second
+// Creates a min-heap priority queue
+struct A_Compare
+{
+	bool operator()(const A_Pos& one, const A_Pos& two) const
+		{ return one.second.first > two.second.first; }
+};
+
+// Priority queue which returns lowest cost element first
+// (clear() keeps its storage, so a reused search doesn't allocate again)
+struct A_Queue : std::priority_queue<A_Pos, std::vector<A_Pos>, A_Compare>
+{
+	void clear() { c.clear(); }
+	size_t capacity() const { return c.capacity(); }
+};
+
+// How much work a search did (on top of [SearchResult::expanded])
+struct SearchStats
+{
+	size_t pushed = 0; // Boxes put in the frontier
+	size_t duplicatePops = 0; // Taken from the frontier after they had already been explored
+	size_t reopened = 0; // A*: boxes pushed again because a cheaper way was found
+	size_t peakFrontier = 0; // Most boxes in the frontier at once
+	size_t peakBytes = 0; // Most memory held by the search's containers (estimated from their sizes)
+	std::uint64_t ns = 0; // Time spent searching (not waiting between animation steps)
+};
+
+// Outcome of a search that ran to the end
+struct SearchResult
+{
+	bool found = false;
+	size_t pathLength = 0, expanded = 0;
+	// Boxes from start to end (empty if not found)
+	std::vector<Pos> path {};
+	SearchStats stats {};
+};
+
+// Everything one search needs, so many searches can exist at once
+/*
+	step() performs only a step of the entire task and keeps its place,
+		so it can continue from where it stopped when called again.
+	run() steps until the search is done.
+
+	Boxes are only recorded when [visualise] is set, because
+	the animation is the only one who needs them.
+	reset() lets one context serve many searches without reallocating:
+		once it has run its biggest search, running more makes no allocations at all
+		(only the path in result() grows, and it keeps its memory too).
+*/
+class SearchContext
+{
+private:
+	const Maze& maze;
+	Pos start, end;
+	int alg;
+	bool visualise;
+	bool searching = true;
+
+	// Search state, one entry per box (indexed by y * width + x)
+	/*
+		Nothing is cleared between searches. Every reset() moves on to a new [epoch]
+			and a box only counts for this search if its stamp is from it
+			(reached: [epoch], closed: [epoch] + 1), so starting over costs nothing.
+	*/
+	std::uint32_t epoch = 0;
+	std::vector<std::uint32_t> stamp {};
+	// Cost from the start (A*) and the box each one was reached from (the start is its own parent)
+	std::vector<int> gCost {}, parentBox {};
+	// Frontier for DFS and BFS
+	BoxDeque container {};
+	// A* open lists
+	OpenList openList = OpenList::BUCKET;
+	TieBreak tieBreak = TieBreak::LARGER_G;
+	BucketQueue buckets {};
+	IndexedHeap heap {};
+
+	// State of each box (when visualising), only set where [boxStamp] is [boxEpoch]
+	std::vector<Box> boxes {};
+	std::vector<std::uint32_t> boxStamp {};
+	std::uint32_t boxEpoch = 0;
+	// Boxes set since take_changes() was last called, and whether [boxes] was wiped since
+	std::vector<Pos> changed {};
+	bool boxesReplaced = true;
+	// Gets every change instead of [changed], when set
+	TraceWriter *trace = nullptr;
+
+	// One direction of a bidirectional search
+	struct Side
+	{
+		Pos to; // Where this side is heading
+		BoxDeque queue {}; // BFS
+		A_Queue open {}; // A*
+		// Same as the one-way search, g is the distance from where this side started
+		std::vector<std::uint32_t> stamp {};
+		std::vector<int> g {}, parent {};
+		// A*: how many boxes in [open] have each g, and the lowest g any of them has
+		//  (only a bound at first, it's moved up to the real one when needed; it never goes down)
+		std::vector<int> atG {};
+		int gMin = 0, gTop = 0;
+	};
+	// 0: from start, 1: from end
+	Side sides[2];
+	int turn = 0;
+	// Length of the shortest path seen so far and the two boxes where the sides met
+	int best = -1;
+	Pos meet[2] {};
+
+	SearchResult res {};
+
+	// One step of whichever algorithm, without timing it
+	bool advance();
+	// Frontier size and memory after a step, for [res.stats]
+	void update_peaks();
+	// Only the frontier size, which is all that changes from step to step
+	void update_frontier();
+	// Stamps for a new search (wiping them all before the counter wraps around)
+	void next_epoch();
+	// Forget the box states of the animation
+	void wipe_boxes();
+	bool reached(const std::vector<std::uint32_t>& stamps, int i) const { return stamps[i] >= epoch; }
+	bool closed(const std::vector<std::uint32_t>& stamps, int i) const { return stamps[i] == epoch + 1; }
+
+	// Depth- and breadth-first search algorithms are in one function
+	//  cause they differ by only one line
+	bool dfs_bfs(bool dfs);
+	// A* algorithm
+	bool a_star();
+	int box_index(const Pos& p) const { return p.y * int(maze.width()) + p.x; }
+	Pos box_pos(int i) const { return {i % int(maze.width()), i / int(maze.width())}; }
+	bool in_maze(const Pos& p) const
+		{ return p.x >= 0 && p.y >= 0 && p.x < int(maze.width()) && p.y < int(maze.height()); }
+	// Bidirectional BFS and A* (also one function)
+	bool bidirectional(bool aStar);
+	// Set the state of a box (and remember that it changed)
+	void mark(const Pos&, Box);
+	// Backtrack shortest path from end to start
+	void show_path();
+	void show_meeting_path();
+
+public:
+	SearchContext(const Maze&, Pos start, Pos end, int algIndex, bool visualise = false);
+
+	// Start over with new endpoints, reusing the memory of the last search
+	void reset(Pos start, Pos end, int algIndex);
+	// Open list and tie-breaking of A* (from the next reset() on)
+	void set_open_list(OpenList list, TieBreak tie) { openList = list, tieBreak = tie; }
+
+	// Send every change of a box to [writer] (see trace.hpp) instead of keeping it for take_changes()
+	// Needs [visualise]; what's shown from the next reset() on goes to it
+	void set_trace(TraceWriter *writer) { trace = writer; }
+
+	// Returns true once the search is done ([steps] steps at most, timed as one)
+	bool step(size_t steps = 1);
+	const SearchResult& run();
+
+	bool done() const { return !searching; }
+	const SearchResult& result() const { return res; }
+	// What the search has done to a box (NONE if nothing, or not visualising)
+	Box box_state(const Pos&) const;
+	// {cost, distance from start} of a box A* has reached, {-1, -1} otherwise
+	Cost_Dist a_star_text(const Pos&) const;
+	// Moves the boxes that changed into [out]
+	// Returns false if the boxes were wiped in between, so every box_state() may be new
+	bool take_changes(std::vector<Pos>& out);
+};
+
+// Run a whole search at once
+SearchResult solve(const Maze&, Pos start, Pos end, int algIndex,
+	OpenList = OpenList::BUCKET, TieBreak = TieBreak::LARGER_G);
+
+// Short name of an algorithm ("dfs", "bfs", "astar", "bibfs", "biastar")
+const char *algorithm_name(int algIndex);
+// One JSON object with the result and stats of a search (no path, no newline)
+void write_json(std::ostream&, const SearchResult&, int algIndex);
+
+// Search for the animation (one search at a time)
+/*
+	start_search() runs the whole search on another thread (see SearchWorker)
+		and play_search() shows what it did, [steps] steps further each call
+		(negative goes back), however far the search itself has got.
+	The search shares [maze] rather than copying it; it may be replaced while it runs.
+*/
+void start_search(const MazeSnapshot& maze, Pos start, Pos end, int algIndex);
+// Returns true once everything the search did is shown
+bool play_search(long steps);
+void rewind_search();
+// Show a path worked out some other way (the last search is dropped)
+void show_result(const Maze&, const SearchResult&);
+Box search_box(const Pos&);
+bool path_not_found();
+// The whole result once it's all shown, before that what's shown so far
+const SearchResult& last_result();
+// Boxes whose state changed since the last call, so drawing can redo only those
+// Returns false when the boxes were all replaced instead (new search or clear_boxes())
+bool box_changes(std::vector<Pos>& changed);
+// Stops the search (and lets go of its maze)
+void clear_boxes();
 
-bool find_path(const Maze&, Pos start, Pos end, int algIndex);
-void draw_box(int);
-void clear_boxes();
\ No newline at end of file
+#endif
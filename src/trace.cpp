@@ -0,0 +1,77 @@
+#include "trace.hpp"
+#include <algorithm>
+#include <chrono>
+
+void SearchWorker::start(MazeSnapshot snapshot, Pos start, Pos end, int alg)
+{
+	stop();
+	maze = std::move(snapshot);
+	cancelled = false, finished = false;
+	drained = false;
+	pending.clear();
+
+	// Events come in a few per box, and a frame empties the ring, so
+	//  a few per box (up to 8 MB) hardly ever makes the search wait
+	const size_t boxes = maze->width() * maze->height();
+	ring.reset(new SpscRing<TraceEvent>(std::max<size_t>(1 << 12, std::min<size_t>(boxes * 4, 1 << 21))));
+
+	#if defined(PLATFORM_WEB)
+		writer = TraceWriter {pending};
+	#else
+		writer = TraceWriter {*ring, cancelled};
+	#endif
+	search.reset(new SearchContext(*maze, start, end, alg, true));
+	search->set_trace(&writer);
+	// Again, now that the start's events have somewhere to go
+	search->reset(start, end, alg);
+
+	#if !defined(PLATFORM_WEB)
+		thread = std::thread([this]
+		{
+			while (!cancelled.load(std::memory_order_relaxed) && !search->step(1024))
+				ring->flush();
+			ring->flush();
+			finished.store(true, std::memory_order_release);
+		});
+	#endif
+}
+
+void SearchWorker::stop()
+{
+	cancelled = true;
+	if (thread.joinable())
+		thread.join();
+	search.reset();
+	maze.reset();
+	drained = false;
+}
+
+void SearchWorker::drain(std::vector<TraceEvent>& out)
+{
+	if (search == nullptr || drained)
+		return;
+
+	#if defined(PLATFORM_WEB)
+		// About half a frame of searching
+		auto t0 = std::chrono::steady_clock::now();
+		while (!search->step(256))
+		{
+			if (std::chrono::steady_clock::now() - t0 > std::chrono::milliseconds(8))
+				break;
+		}
+		out.insert(out.end(), pending.begin(), pending.end());
+		pending.clear();
+		drained = search->done();
+	#else
+		// Everything pushed before [finished] was set is in the ring by now
+		bool last = finished.load(std::memory_order_acquire);
+		ring->pop_all(out);
+		drained = last;
+	#endif
+}
+
+const SearchResult& SearchWorker::result() const
+{
+	static const SearchResult none {};
+	return (search != nullptr && drained) ? search->result() : none;
+}
@@ -0,0 +1,165 @@
+#ifndef TRACE_H_
+#define TRACE_H_
+
+#include "solver.hpp"
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <thread>
+#include <vector>
+
+// One thing a search showed: a box taking a state, or every box going blank
+// 32 bits: the box (y * width + x) above 3 bits of state, so boxes go up to 2^29
+struct TraceEvent
+{
+	std::uint32_t bits = 0;
+
+	TraceEvent() = default;
+	TraceEvent(int box, Box state) : bits((std::uint32_t(box) << 3) | std::uint32_t(state)) {}
+	static TraceEvent wipe() { TraceEvent e {}; e.bits = WIPE; return e; }
+
+	bool is_wipe() const { return (bits & 7) == WIPE; }
+	int box() const { return int(bits >> 3); }
+	Box state() const { return Box(bits & 7); }
+
+private:
+	enum : std::uint32_t { WIPE = 7 };
+};
+
+// Fixed-size queue between exactly one thread that pushes and one that pops, without locks
+/*
+	Each side only writes its own index ([tail] is the pusher's, [head] the popper's)
+		and reads the other's with acquire, so what was written before an index moved
+		is seen by the other side once it sees the new index.
+	The indexes only grow; the capacity is a power of two, so an index masked is its slot.
+	The pusher keeps the last [head] it saw and only reads it again when the queue looks full,
+		and only moves [tail] every [BATCH] items (or flush()), so the popper
+		isn't pulling the cache line of [tail] away after every single push.
+	The popper takes everything there is at once, so it reads [tail] once a call.
+*/
+template <typename T>
+class SpscRing
+{
+private:
+	std::vector<T> slots;
+	size_t mask;
+	// Apart from each other (and from [slots], which both read), so the threads
+	//  don't fight over one cache line
+	char pad0[64];
+	std::atomic<size_t> head {0};
+	char pad1[64];
+	std::atomic<size_t> tail {0};
+	// Pusher's: where the next item goes, and the last [head] it saw
+	size_t next = 0, headSeen = 0;
+	enum : size_t { BATCH = 64 };
+
+	static size_t round_up(size_t n) { size_t p = 1; while (p < n) p <<= 1; return p; }
+
+public:
+	explicit SpscRing(size_t capacity) : slots(round_up(capacity)), mask(slots.size() - 1) {}
+
+	// Pusher: false if full
+	bool push(const T& item)
+	{
+		if (next - headSeen == slots.size())
+		{
+			headSeen = head.load(std::memory_order_acquire);
+			if (next - headSeen == slots.size())
+			{
+				flush();
+				return false;
+			}
+		}
+		slots[next++ & mask] = item;
+		if (next % BATCH == 0)
+			flush();
+		return true;
+	}
+	// Pusher: let the popper see everything pushed so far
+	void flush() { tail.store(next, std::memory_order_release); }
+
+	// Popper: moves everything in the queue to the end of [out], returns how many
+	size_t pop_all(std::vector<T>& out)
+	{
+		size_t h = head.load(std::memory_order_relaxed), t = tail.load(std::memory_order_acquire);
+		if (t == h)
+			return 0;
+		for (size_t i = h; i != t; i++)
+			out.push_back(slots[i & mask]);
+		head.store(t, std::memory_order_release);
+		return t - h;
+	}
+
+	size_t capacity() const { return slots.size(); }
+};
+
+// Where a search sends its events: into a ring another thread empties, or onto a list
+class TraceWriter
+{
+private:
+	SpscRing<TraceEvent> *ring = nullptr;
+	std::vector<TraceEvent> *list = nullptr;
+	const std::atomic<bool> *cancelled = nullptr;
+
+public:
+	TraceWriter() = default;
+	// Waits while [ring] is full, unless [cancelled] is set (then events are dropped)
+	TraceWriter(SpscRing<TraceEvent>& ring, const std::atomic<bool>& cancelled)
+		: ring(&ring), cancelled(&cancelled) {}
+	explicit TraceWriter(std::vector<TraceEvent>& list) : list(&list) {}
+
+	void put(TraceEvent e)
+	{
+		if (list != nullptr)
+			list->push_back(e);
+		else
+		{
+			while (!ring->push(e) && !cancelled->load(std::memory_order_relaxed))
+				std::this_thread::yield();
+		}
+	}
+};
+
+// One search running as fast as it can on a thread of its own, for the animation
+/*
+	Everything it shows comes out of drain() as TraceEvents, in order,
+		for a Replay to play back at whatever speed it likes.
+	It holds on to its maze, so the one the viewer shows can be replaced
+		by an edited copy while the search goes on reading the old one.
+
+	Builds without threads (the web build) run the search in drain() instead,
+		a few milliseconds each call, so a frame never waits long for it.
+*/
+class SearchWorker
+{
+private:
+	MazeSnapshot maze {}; // What [search] reads (declared first, so it goes last)
+	std::unique_ptr<SearchContext> search {};
+	std::unique_ptr<SpscRing<TraceEvent>> ring {};
+	std::vector<TraceEvent> pending {}; // Without threads: events made since the last drain()
+	TraceWriter writer {};
+	std::thread thread {};
+	std::atomic<bool> cancelled {false}, finished {false};
+	bool drained = false; // Every event is out (after [finished])
+
+public:
+	SearchWorker() = default;
+	SearchWorker(const SearchWorker&) = delete;
+	SearchWorker& operator=(const SearchWorker&) = delete;
+	~SearchWorker() { stop(); }
+
+	// Stops the search that's running (if any) and starts this one
+	void start(MazeSnapshot, Pos start, Pos end, int algIndex);
+	// Gives up on the search and waits for the thread
+	void stop();
+
+	// Adds the events made since the last call to [out]
+	void drain(std::vector<TraceEvent>& out);
+	// The search has finished and drain() has given out everything
+	bool done() const { return drained; }
+	bool running() const { return search != nullptr && !drained; }
+	// What the search found (once done())
+	const SearchResult& result() const;
+};
+
+#endif
@@ -0,0 +1,124 @@
+#include "tree_index.hpp"
+#include <algorithm>
+
+// Root every tree of the maze with a BFS, so parents come before their children
+TreeIndex::TreeIndex(const Maze& maze) : col(int(maze.width())), row(int(maze.height()))
+{
+	const int n = col * row;
+	parent.assign(n, -1);
+	jump.assign(n, -1);
+	depth.assign(n, 0);
+
+	std::vector<int> order {};
+	order.reserve(n);
+	size_t edges = 0, trees = 0;
+
+	for (int root = 0; root < n; root++)
+	{
+		if (parent[root] != -1)
+			continue;
+
+		// A root is its own parent
+		trees++;
+		parent[root] = jump[root] = root;
+		order.push_back(root);
+
+		for (size_t i = order.size() - 1; i < order.size(); i++)
+		{
+			int curr = order[i];
+			for (Pos next : maze.paths(pos(curr)))
+			{
+				int j = index(next);
+				edges++;
+				if (parent[j] != -1)
+					continue;
+
+				parent[j] = curr;
+				depth[j] = depth[curr] + 1;
+
+				// Jump twice as far as the parent does when the parent's jump and
+				//  its jump's jump cover the same distance, otherwise jump to the parent
+				int p = parent[j], pj = jump[p];
+				if (depth[p] - depth[pj] == depth[pj] - depth[jump[pj]])
+					jump[j] = jump[pj];
+				else
+					jump[j] = p;
+
+				order.push_back(j);
+			}
+		}
+	}
+
+	// Every path was counted from both of its ends
+	edges /= 2;
+	// A forest has one edge less than boxes per tree
+	acyclic = (edges + trees == size_t(n));
+	connected = (trees == 1);
+}
+
+int TreeIndex::lca(int a, int b) const
+{
+	if (depth[a] < depth[b])
+		std::swap(a, b);
+
+	// Bring [a] up to the depth of [b]
+	while (depth[a] > depth[b])
+		a = (depth[jump[a]] >= depth[b]) ? jump[a] : parent[a];
+
+	// Go up together until they meet
+	while (a != b)
+	{
+		// Two different roots, they are in different trees
+		if (parent[a] == a)
+			return -1;
+
+		if (jump[a] != jump[b])
+			a = jump[a], b = jump[b];
+		else
+			a = parent[a], b = parent[b];
+	}
+
+	return a;
+}
+
+int TreeIndex::distance(const Pos& a, const Pos& b) const
+{
+	if (!in_maze(a) || !in_maze(b))
+		return -1;
+
+	int i = index(a), j = index(b);
+	int common = lca(i, j);
+	if (common == -1)
+		return -1;
+
+	return depth[i] + depth[j] - 2 * depth[common];
+}
+
+SearchResult TreeIndex::query(const Pos& a, const Pos& b) const
+{
+	SearchResult res {};
+	if (!in_maze(a) || !in_maze(b))
+		return res;
+
+	int i = index(a), j = index(b);
+	int common = lca(i, j);
+	if (common == -1)
+		return res;
+
+	res.found = true;
+	res.path.reserve(depth[i] + depth[j] - 2 * depth[common] + 1);
+
+	// Up from [a]
+	for (; i != common; i = parent[i])
+		res.path.push_back(pos(i));
+	res.path.push_back(pos(common));
+
+	// Up from [b], then flipped to go down
+	size_t mid = res.path.size();
+	for (; j != common; j = parent[j])
+		res.path.push_back(pos(j));
+	std::reverse(res.path.begin() + mid, res.path.end());
+
+	res.pathLength = res.path.size();
+	return res;
+}
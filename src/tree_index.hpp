@@ -0,0 +1,49 @@
+#ifndef TREE_INDEX_H_
+#define TREE_INDEX_H_
+
+#include "maze.hpp"
+#include "solver.hpp"
+#include <vector>
+
+// Answers path queries on a perfect maze without searching
+/*
+	A perfect maze has exactly one path between any two boxes, so its
+		boxes form a tree. Rooting the tree at the top-left box, the path
+		between [a] and [b] goes up from [a] to their lowest common ancestor
+		and back down to [b].
+
+	Built once per maze in O(boxes). Every box stores its parent, its depth and
+		one jump pointer (skew-binary jumps), which finds the common ancestor in
+		O(log n) while only needing O(1) memory per box.
+
+	If the maze isn't perfect (perfect() is false), the answers are still paths,
+		but along a spanning tree, so they might not be the shortest.
+*/
+class TreeIndex
+{
+private:
+	int col = 0, row = 0;
+	// Indexed by y * width + x
+	std::vector<int> parent {}, jump {}, depth {};
+	bool acyclic = false, connected = false;
+
+	int index(const Pos& p) const { return p.y * col + p.x; }
+	Pos pos(int i) const { return {i % col, i / col}; }
+	bool in_maze(const Pos& p) const { return p.x >= 0 && p.y >= 0 && p.x < col && p.y < row; }
+	// Lowest common ancestor (or -1 if they are not connected)
+	int lca(int, int) const;
+
+public:
+	TreeIndex() = default;
+	explicit TreeIndex(const Maze&);
+
+	// One path between every pair of boxes
+	bool perfect() const { return acyclic && connected; }
+
+	// Number of steps between two boxes (-1 if there is no path)
+	int distance(const Pos&, const Pos&) const;
+	// The boxes on the way, in time proportional to its length
+	SearchResult query(const Pos&, const Pos&) const;
+};
+
+#endif
@@ -0,0 +1,338 @@
+// Benchmarks the hot paths of the core (no raylib)
+/*
+	Usage: maze-bench [--sizes 50,100,...] [--seeds n] [--budget seconds]
+		[--csv file] [--json file]
+
+	For every size and seed it times
+		- Maze::Maze(col, row)
+		- generate for every [MazeAlgorithm], and generate_tiled with the backtracker on every core
+		- Maze::paths over every box
+		- a full solve from the top-left to the bottom-right box for each [Algorithm]
+		(and A* once more with the indexed heap as its open list,
+		and BFS as a bit-parallel flood on a BitGrid, which is built first)
+		- a FlowField to the bottom-right box
+		- a PathCache lookup of that BFS solve again (cache_hit),
+			and of the middle half of its path, backwards (cache_sub)
+		- D* Lite repairing that path after a random wall is knocked down (dstar_replan)
+		- BFS on a SearchWorker, with every event it shows taken out of its ring (worker_trace)
+		- braid with half of the dead ends gone (gen_braid), and on that maze
+			an HpaGraph with 32 x 32 clusters (hpa_build), then A* over boxes (astar_braid)
+			and HPA* (hpa_braid) from corner to corner
+	and reports the median and 95th percentile time, boxes per second and peak RSS.
+
+	Solves also report [allocs]: heap allocations per search once a [SearchContext]
+		is reused (after one search to warm it up), which should be 0.
+		Every operator new of the process is counted for it.
+
+	Once a single sample of a size takes longer than [budget] seconds,
+		bigger sizes are skipped, so a slow change can't hang the run.
+*/
+#include "../src/generator.hpp"
+#include "../src/solver.hpp"
+#include "../src/bitboard.hpp"
+#include "../src/flow_field.hpp"
+#include "../src/path_cache.hpp"
+#include "../src/dstar_lite.hpp"
+#include "../src/trace.hpp"
+#include "../src/hpa.hpp"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <new>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include <sys/resource.h>
+
+struct Row
+{
+	std::string op;
+	int w, h;
+	std::vector<double> ms {}; // One entry per sample
+	long peakKB = 0;
+	long allocs = -1; // Allocations per reused solve (-1 if not counted)
+
+	Row(std::string op, int w, int h) : op(op), w(w), h(h) {}
+
+	double percentile(double p) const
+	{
+		std::vector<double> sorted = ms;
+		std::sort(sorted.begin(), sorted.end());
+		size_t i = size_t(p * (sorted.size() - 1) + 0.5);
+		return sorted[i];
+	}
+	double cells_per_sec() const
+		{ return double(w) * h / (percentile(0.5) / 1000.0); }
+};
+
+static const char *genNames[] = {"gen_backtracker", "gen_kruskal", "gen_prim", "gen_wilson", "gen_eller"};
+
+// Allocations made so far (replacing the global operator new counts all of them)
+static std::atomic<size_t> allocations {0};
+
+void *operator new(size_t size)
+{
+	allocations.fetch_add(1, std::memory_order_relaxed);
+	if (void *p = std::malloc(size ? size : 1))
+		return p;
+	throw std::bad_alloc();
+}
+
+void operator delete(void *p) noexcept
+{
+	std::free(p);
+}
+
+// Peak resident set size of the process so far (KB on Linux)
+static long peak_rss_kb()
+{
+	rusage usage {};
+	getrusage(RUSAGE_SELF, &usage);
+	return usage.ru_maxrss;
+}
+
+template <typename F>
+static double time_ms(F f)
+{
+	auto t0 = std::chrono::steady_clock::now();
+	f();
+	return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+}
+
+static void usage(const char *prog)
+{
+	std::fprintf(stderr, "usage: %s [--sizes 50,100,...] [--seeds n] [--budget seconds] "
+		"[--csv file] [--json file]\n", prog);
+	std::exit(1);
+}
+
+int main(int argc, char **argv)
+{
+	std::vector<int> sizes {50, 100, 250, 500, 1000, 2000, 4000};
+	int seeds = 3;
+	double budget = 10;
+	std::string csvFile {}, jsonFile {};
+
+	for (int i = 1; i < argc; i++)
+	{
+		std::string arg = argv[i];
+		if (i + 1 >= argc)
+			usage(argv[0]);
+
+		if (arg == "--sizes")
+		{
+			sizes.clear();
+			std::istringstream iss {argv[++i]};
+			std::string size {};
+			while (std::getline(iss, size, ','))
+				sizes.push_back(std::atoi(size.c_str()));
+		}
+		else if (arg == "--seeds")
+			seeds = std::atoi(argv[++i]);
+		else if (arg == "--budget")
+			budget = std::atof(argv[++i]);
+		else if (arg == "--csv")
+			csvFile = argv[++i];
+		else if (arg == "--json")
+			jsonFile = argv[++i];
+		else
+			usage(argv[0]);
+	}
+	if (sizes.empty() || seeds <= 0)
+		usage(argv[0]);
+
+	std::vector<Row> rows {};
+	// Keeps the compiler from throwing away work whose result is unused
+	volatile size_t sink = 0;
+
+	for (int n : sizes)
+	{
+		std::printf("# %dx%d\n", n, n);
+		std::fflush(stdout);
+
+		Row construct {"construct", n, n}, tiled {"gen_tiled", n, n}, paths {"paths", n, n};
+		Row heapAStar {"astar_heap", n, n}, bitsBuild {"bits_grid", n, n}, bitsBfs {"bfs_bits", n, n};
+		Row flow {"flow_field", n, n}, cacheHit {"cache_hit", n, n}, cacheSub {"cache_sub", n, n};
+		Row replan {"dstar_replan", n, n}, traced {"worker_trace", n, n};
+		Row braided {"gen_braid", n, n}, hpaBuild {"hpa_build", n, n};
+		Row braidAStar {"astar_braid", n, n}, braidHpa {"hpa_braid", n, n};
+		std::vector<Row> gens {}, solves {};
+		for (int g = BACKTRACKER; g < NUM_MAZE_ALGORITHMS; g++)
+			gens.push_back({genNames[g], n, n});
+		for (int alg = DFS; alg < NUM_ALGORITHMS; alg++)
+			solves.push_back({algorithm_name(alg), n, n});
+
+		for (int seed = 1; seed <= seeds; seed++)
+		{
+			construct.ms.push_back(time_ms([&]{ Maze m(n, n); sink += m.width(); }));
+
+			Maze maze {};
+			for (int g = NUM_MAZE_ALGORITHMS - 1; g >= BACKTRACKER; g--)
+				gens[g].ms.push_back(time_ms([&]{ maze = generate(n, n, seed, g); }));
+			// [maze] is from the backtracker now
+
+			tiled.ms.push_back(time_ms([&]{ sink += generate_tiled(n, n, seed).width(); }));
+
+			paths.ms.push_back(time_ms([&]
+			{
+				for (int y = 0; y < n; y++)
+					for (int x = 0; x < n; x++)
+						sink += maze.paths({x, y}).size();
+			}));
+
+			for (int alg = DFS; alg < NUM_ALGORITHMS; alg++)
+			{
+				solves[alg].ms.push_back(time_ms([&]
+				{
+					sink += solve(maze, {0, 0}, {n - 1, n - 1}, alg).expanded;
+				}));
+
+				// Once per size: a warm context shouldn't allocate at all
+				if (seed == 1)
+				{
+					const int repeats = 3;
+					SearchContext search {maze, {0, 0}, {n - 1, n - 1}, alg};
+					search.run();
+					size_t before = allocations.load();
+					for (int k = 0; k < repeats; k++)
+					{
+						search.reset({0, 0}, {n - 1, n - 1}, alg);
+						sink += search.run().expanded;
+					}
+					solves[alg].allocs = long((allocations.load() - before) / repeats);
+				}
+			}
+			heapAStar.ms.push_back(time_ms([&]
+			{
+				sink += solve(maze, {0, 0}, {n - 1, n - 1}, A_STAR, OpenList::HEAP).expanded;
+			}));
+
+			BitGrid grid {};
+			bitsBuild.ms.push_back(time_ms([&]{ grid = BitGrid {maze}; }));
+			bitsBfs.ms.push_back(time_ms([&]{ sink += grid.solve({0, 0}, {n - 1, n - 1}).expanded; }));
+
+			flow.ms.push_back(time_ms([&]{ sink += FlowField(maze, {n - 1, n - 1}).distance({0, 0}); }));
+
+			PathCache cache {};
+			const SearchResult whole = cache.solve(maze, {0, 0}, {n - 1, n - 1}, BFS);
+			const Pos from = whole.path[whole.path.size() / 4], to = whole.path[whole.path.size() * 3 / 4];
+			SearchResult cached {};
+			cacheHit.ms.push_back(time_ms([&]{ sink += cache.find(maze, {0, 0}, {n - 1, n - 1}, BFS, cached); }));
+			cacheSub.ms.push_back(time_ms([&]{ sink += cache.find(maze, to, from, BFS, cached); }));
+
+			DStarLite planner {maze, {0, 0}, {n - 1, n - 1}};
+			planner.replan();
+			Random random {std::uint64_t(seed)};
+			Pos box {}, next {};
+			do
+			{
+				box = {int(random.below(n)), int(random.below(n))};
+				next = random.below(2) ? Pos {box.x + 1, box.y} : Pos {box.x, box.y + 1};
+			} while (!maze.open_path(box, next));
+			replan.ms.push_back(time_ms([&]
+			{
+				planner.wall_changed(box, next);
+				sink += planner.replan().expanded;
+			}));
+
+			SearchWorker worker {};
+			std::vector<TraceEvent> events {};
+			const MazeSnapshot shared = std::make_shared<const Maze>(maze);
+			traced.ms.push_back(time_ms([&]
+			{
+				worker.start(shared, {0, 0}, {n - 1, n - 1}, BFS);
+				// Leaving the worker the core, on a machine with just one
+				while (!worker.done())
+				{
+					worker.drain(events);
+					std::this_thread::yield();
+				}
+				sink += events.size();
+			}));
+
+			Maze loopy = maze;
+			braided.ms.push_back(time_ms([&]{ sink += braid(loopy, 0.5, std::uint64_t(seed)); }));
+			HpaGraph hpa {};
+			hpaBuild.ms.push_back(time_ms([&]{ hpa = HpaGraph {loopy}; }));
+			braidAStar.ms.push_back(time_ms([&]{ sink += solve(loopy, {0, 0}, {n - 1, n - 1}, A_STAR).expanded; }));
+			braidHpa.ms.push_back(time_ms([&]{ sink += hpa.solve({0, 0}, {n - 1, n - 1}).expanded; }));
+		}
+
+		const size_t first = rows.size();
+		rows.push_back(construct);
+		rows.insert(rows.end(), gens.begin(), gens.end());
+		rows.push_back(tiled);
+		rows.push_back(paths);
+		rows.insert(rows.end(), solves.begin(), solves.end());
+		rows.push_back(heapAStar);
+		rows.push_back(bitsBuild);
+		rows.push_back(bitsBfs);
+		rows.push_back(flow);
+		rows.push_back(cacheHit);
+		rows.push_back(cacheSub);
+		rows.push_back(replan);
+		rows.push_back(traced);
+		rows.push_back(braided);
+		rows.push_back(hpaBuild);
+		rows.push_back(braidAStar);
+		rows.push_back(braidHpa);
+
+		// Peak so far; sizes grow, so this is (close to) the peak of this size
+		long peak = peak_rss_kb();
+		double slowest = 0;
+		for (size_t i = first; i < rows.size(); i++)
+		{
+			rows[i].peakKB = peak;
+			slowest = std::max(slowest, *std::max_element(rows[i].ms.begin(), rows[i].ms.end()));
+		}
+
+		if (slowest > budget * 1000)
+		{
+			std::printf("# %.1fs sample exceeds budget, skipping bigger sizes\n", slowest / 1000);
+			break;
+		}
+	}
+
+	std::printf("%-16s %6s %6s %12s %12s %14s %10s %7s\n",
+		"op", "w", "h", "median_ms", "p95_ms", "cells_per_s", "peak_kb", "allocs");
+	for (const Row& r : rows)
+	{
+		std::printf("%-16s %6d %6d %12.3f %12.3f %14.0f %10ld %7s\n",
+			r.op.c_str(), r.w, r.h, r.percentile(0.5), r.percentile(0.95), r.cells_per_sec(), r.peakKB,
+			r.allocs < 0 ? "-" : std::to_string(r.allocs).c_str());
+	}
+
+	if (!csvFile.empty())
+	{
+		std::ofstream out {csvFile};
+		out << "op,w,h,samples,median_ms,p95_ms,cells_per_s,peak_kb,allocs\n";
+		for (const Row& r : rows)
+		{
+			out << r.op << ',' << r.w << ',' << r.h << ',' << r.ms.size() << ','
+				<< r.percentile(0.5) << ',' << r.percentile(0.95) << ','
+				<< r.cells_per_sec() << ',' << r.peakKB << ',' << r.allocs << '\n';
+		}
+	}
+
+	if (!jsonFile.empty())
+	{
+		std::ofstream out {jsonFile};
+		out << "[\n";
+		for (size_t i = 0; i < rows.size(); i++)
+		{
+			const Row& r = rows[i];
+			out << "  {\"op\": \"" << r.op << "\", \"w\": " << r.w << ", \"h\": " << r.h
+				<< ", \"samples\": " << r.ms.size()
+				<< ", \"median_ms\": " << r.percentile(0.5) << ", \"p95_ms\": " << r.percentile(0.95)
+				<< ", \"cells_per_s\": " << r.cells_per_sec() << ", \"peak_kb\": " << r.peakKB << ", \"allocs\": " << r.allocs << "}"
+				<< (i + 1 < rows.size() ? ",\n" : "\n");
+		}
+		out << "]\n";
+	}
+
+	return 0;
+}
@@ -0,0 +1,554 @@
+// Runs the generator and solvers without raylib or a window
+/*
+	Usage: maze-headless [-w width] [-h height] [-s seed] [-g backtracker|kruskal|prim|wilson|eller]
+		[-a dfs|bfs|astar|bibfs|biastar|all]
+		[--from x y] [--to x y] [--queries file] [-j threads] [--tree] [--junctions] [--bits] [--flow agents] [--tiled size]
+		[--cache entries] [--edits n] [--braid fraction] [--hpa size] [--save file.maze] [--load file.maze] [--external dir] [--json file]
+		[--open bucket|heap] [--tie larger|smaller]
+	       maze-headless --stream file [-w width] [-h height] [-s seed]
+
+	Generates one maze, runs each requested search to completion
+		and prints the path length, nodes expanded and wall-clock time.
+
+	With --queries, every line of [file] ("-" is stdin) is a "startX startY endX endY" pair.
+	They are solved on [threads] workers and printed in the order they were given.
+
+	With --tiled, the maze is made from [size] x [size] tiles on [threads] workers.
+	With --braid, [fraction] (0 to 1) of the dead ends get a second way out, which makes loops.
+
+	With --tree, a TreeIndex is built once and answers the queries without searching.
+	With --junctions, the searches run on a JunctionGraph of the maze (one thread).
+	With --flow, a FlowField to the end box is built once and [agents] starts
+		(random, from the seed) follow it; for comparison each is then found with BFS as well.
+	With --hpa, A* runs on an HpaGraph of [size] x [size] clusters (one thread);
+		the other searches are unchanged.
+	With --bits, BFS runs as a bit-parallel flood on a BitGrid of the maze (one thread);
+		the other searches are unchanged.
+	With --edits, the path from [from] to [to] is found with D* Lite, then [n] random walls
+		are put up or knocked down one at a time and it's repaired after each;
+		for comparison A* solves every version of the maze from scratch too.
+	With --cache, queries go through a PathCache of [entries] paths first (one thread),
+		so repeated queries, and ones along a path found before, aren't searched again.
+
+	With --external, the searches keep their state in a scratch file in [dir]
+		(see external.hpp), for mazes that don't fit in memory; peak_kb is then only the frontier.
+
+	--open and --tie pick the open list and tie-breaking of A* (see open_list.hpp).
+
+	--json writes the result and stats (see SearchStats) of every search to [file] as a JSON array.
+
+	--save writes the maze to a maze file, --load opens one instead of generating
+		(size, seed and generator then come from the file).
+
+	With --stream, an Eller's maze is written row by row to a maze file and never
+		held in memory, so [height] can be huge. "-" sends the raw rows of
+		generate_rows() to stdout instead.
+*/
+#include "../src/generator.hpp"
+#include "../src/eller.hpp"
+#include "../src/solver.hpp"
+#include "../src/batch.hpp"
+#include "../src/tree_index.hpp"
+#include "../src/junction.hpp"
+#include "../src/external.hpp"
+#include "../src/bitboard.hpp"
+#include "../src/flow_field.hpp"
+#include "../src/path_cache.hpp"
+#include "../src/dstar_lite.hpp"
+#include "../src/hpa.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+static const char *mazeNames[] = {"backtracker", "kruskal", "prim", "wilson", "eller"};
+
+static void usage(const char *prog)
+{
+	std::fprintf(stderr, "usage: %s [-w width] [-h height] [-s seed] [-g backtracker|kruskal|prim|wilson|eller] "
+		"[-a dfs|bfs|astar|bibfs|biastar|all] [--from x y] [--to x y] [--queries file] [-j threads] [--tree] [--junctions] [--bits] [--flow agents] [--tiled size] [--cache entries] [--edits n] [--braid fraction] [--hpa size]\n"
+		"       [--save file.maze] [--load file.maze] [--external dir] [--json file]\n"
+		"       [--open bucket|heap] [--tie larger|smaller]\n"
+		"       %s --stream file [-w width] [-h height] [-s seed]\n", prog, prog);
+	std::exit(1);
+}
+
+// One "startX startY endX endY" pair per line ("-" reads stdin)
+static bool read_queries(const std::string& name, std::vector<std::pair<Pos, Pos>>& queries)
+{
+	std::ifstream file {};
+	if (name != "-")
+		file.open(name);
+	std::istream& in = (name == "-") ? std::cin : file;
+	if (!in)
+		return false;
+
+	queries.clear();
+	Pos s, e;
+	while (in >> s.x >> s.y >> e.x >> e.y)
+		queries.push_back({s, e});
+	return true;
+}
+
+// Results of the searches as a JSON array
+static bool write_runs(const std::string& name, const std::vector<std::pair<int, SearchResult>>& runs)
+{
+	std::ofstream out {name};
+	out << "[\n";
+	for (size_t i = 0; i < runs.size(); i++)
+	{
+		out << "  ";
+		write_json(out, runs[i].second, runs[i].first);
+		out << (i + 1 < runs.size() ? ",\n" : "\n");
+	}
+	out << "]\n";
+	return bool(out);
+}
+
+int main(int argc, char **argv)
+{
+	int w = 40, h = 30;
+	unsigned long long seed = std::time(NULL);
+	int mazeAlg = BACKTRACKER;
+	std::string algName = "all";
+	Pos start {0, 0}, end {-1, -1};
+	std::string queryFile {}, streamFile {}, saveFile {}, loadFile {}, externalDir {}, jsonFile {};
+	unsigned threads = 0;
+	bool tree = false, junctions = false, bits = false;
+	int tileSize = 0, agents = 0, cacheSize = 0, edits = 0, clusterSize = 0;
+	double braidFraction = 0;
+	OpenList openList = OpenList::BUCKET;
+	TieBreak tie = TieBreak::LARGER_G;
+
+	for (int i = 1; i < argc; i++)
+	{
+		std::string arg = argv[i];
+		// Does this flag have [n] values after it?
+		auto has = [&](int n) { return i + n < argc; };
+
+		if (arg == "-w" && has(1))
+			w = std::atoi(argv[++i]);
+		else if (arg == "-h" && has(1))
+			h = std::atoi(argv[++i]);
+		else if (arg == "-s" && has(1))
+			seed = std::strtoull(argv[++i], nullptr, 10);
+		else if (arg == "-g" && has(1))
+		{
+			std::string name = argv[++i];
+			mazeAlg = -1;
+			for (int g = BACKTRACKER; g < NUM_MAZE_ALGORITHMS; g++)
+			{
+				if (name == mazeNames[g])
+					mazeAlg = g;
+			}
+			if (mazeAlg == -1)
+				usage(argv[0]);
+		}
+		else if (arg == "-a" && has(1))
+			algName = argv[++i];
+		else if (arg == "--from" && has(2))
+			start = {std::atoi(argv[i + 1]), std::atoi(argv[i + 2])}, i += 2;
+		else if (arg == "--to" && has(2))
+			end = {std::atoi(argv[i + 1]), std::atoi(argv[i + 2])}, i += 2;
+		else if (arg == "--queries" && has(1))
+			queryFile = argv[++i];
+		else if (arg == "-j" && has(1))
+			threads = std::atoi(argv[++i]);
+		else if (arg == "--tree")
+			tree = true;
+		else if (arg == "--junctions")
+			junctions = true;
+		else if (arg == "--bits")
+			bits = true;
+		else if (arg == "--flow" && has(1))
+			agents = std::atoi(argv[++i]);
+		else if (arg == "--braid" && has(1))
+			braidFraction = std::atof(argv[++i]);
+		else if (arg == "--hpa" && has(1))
+			clusterSize = std::atoi(argv[++i]);
+		else if (arg == "--edits" && has(1))
+			edits = std::atoi(argv[++i]);
+		else if (arg == "--cache" && has(1))
+			cacheSize = std::atoi(argv[++i]);
+		else if (arg == "--tiled" && has(1))
+			tileSize = std::atoi(argv[++i]);
+		else if (arg == "--stream" && has(1))
+			streamFile = argv[++i];
+		else if (arg == "--save" && has(1))
+			saveFile = argv[++i];
+		else if (arg == "--load" && has(1))
+			loadFile = argv[++i];
+		else if (arg == "--external" && has(1))
+			externalDir = argv[++i];
+		else if (arg == "--json" && has(1))
+			jsonFile = argv[++i];
+		else if (arg == "--open" && has(1))
+		{
+			std::string name = argv[++i];
+			if (name != "bucket" && name != "heap")
+				usage(argv[0]);
+			openList = (name == "heap") ? OpenList::HEAP : OpenList::BUCKET;
+		}
+		else if (arg == "--tie" && has(1))
+		{
+			std::string name = argv[++i];
+			if (name != "larger" && name != "smaller")
+				usage(argv[0]);
+			tie = (name == "smaller") ? TieBreak::SMALLER_G : TieBreak::LARGER_G;
+		}
+		else
+			usage(argv[0]);
+	}
+
+	if (w <= 0 || h <= 0)
+		usage(argv[0]);
+
+	std::vector<int> algs {};
+	for (int a = DFS; a < NUM_ALGORITHMS; a++)
+	{
+		if (algName == "all" || algName == algorithm_name(a))
+			algs.push_back(a);
+	}
+	if (algs.empty())
+		usage(argv[0]);
+
+	using Clock = std::chrono::steady_clock;
+
+	auto t0 = Clock::now();
+	if (!streamFile.empty())
+	{
+		bool ok = true;
+		if (streamFile == "-")
+		{
+			generate_rows(w, h, seed, std::cout);
+			ok = bool(std::cout.flush());
+		}
+		else
+			ok = generate_file(w, h, seed, streamFile);
+		if (!ok)
+		{
+			std::fprintf(stderr, "%s: can't write %s\n", argv[0], streamFile.c_str());
+			return 1;
+		}
+
+		double ms = std::chrono::duration<double, std::milli>(Clock::now() - t0).count();
+		// Keep stdout clean for the maze itself
+		std::fprintf(stderr, "maze %dx%d seed %llu (eller) streamed in %.3f ms (%.0f rows/s)\n",
+			w, h, seed, ms, h / (ms / 1000.0));
+		return 0;
+	}
+
+	Maze maze {};
+	if (!loadFile.empty())
+	{
+		MazeInfo info {};
+		if (!maze.load(loadFile, &info))
+		{
+			std::fprintf(stderr, "%s: %s is not a maze file\n", argv[0], loadFile.c_str());
+			return 1;
+		}
+		w = int(maze.width()), h = int(maze.height());
+		seed = info.seed, mazeAlg = info.generator;
+	}
+	else if (tileSize > 0)
+		maze = generate_tiled(w, h, seed, mazeAlg, threads, tileSize);
+	else
+		maze = generate(w, h, seed, mazeAlg);
+	double genMs = std::chrono::duration<double, std::milli>(Clock::now() - t0).count();
+
+	const char *mazeName = (mazeAlg >= 0 && mazeAlg < NUM_MAZE_ALGORITHMS) ? mazeNames[mazeAlg] : "unknown";
+	std::printf("maze %dx%d seed %llu (%s%s) %s in %.3f ms\n", w, h, seed, mazeName,
+		(tileSize > 0) ? ", tiled" : "", loadFile.empty() ? "generated" : "loaded", genMs);
+
+	if (braidFraction > 0)
+	{
+		t0 = Clock::now();
+		size_t opened = braid(maze, braidFraction, seed);
+		std::printf("braided: %zu walls knocked down in %.3f ms\n", opened,
+			std::chrono::duration<double, std::milli>(Clock::now() - t0).count());
+	}
+
+	if (!saveFile.empty())
+	{
+		MazeInfo info {};
+		info.seed = seed, info.generator = mazeAlg;
+		t0 = Clock::now();
+		if (!maze.save(saveFile, info))
+		{
+			std::fprintf(stderr, "%s: can't write %s\n", argv[0], saveFile.c_str());
+			return 1;
+		}
+		std::printf("saved to %s in %.3f ms\n", saveFile.c_str(),
+			std::chrono::duration<double, std::milli>(Clock::now() - t0).count());
+	}
+
+	// Default goal is the bottom-right box
+	if (end == Pos(-1, -1))
+		end = {w - 1, h - 1};
+
+	if (tree)
+	{
+		t0 = Clock::now();
+		TreeIndex index {maze};
+		double buildMs = std::chrono::duration<double, std::milli>(Clock::now() - t0).count();
+		std::printf("tree index built in %.3f ms (%s)\n", buildMs,
+			index.perfect() ? "perfect maze" : "not a perfect maze, paths may not be shortest");
+
+		std::vector<std::pair<Pos, Pos>> queries {{start, end}};
+		if (!queryFile.empty() && !read_queries(queryFile, queries))
+		{
+			std::fprintf(stderr, "%s: can't read %s\n", argv[0], queryFile.c_str());
+			return 1;
+		}
+
+		std::printf("%-8s %-20s %10s %12s\n", "query", "endpoints", "path", "time_us");
+		for (size_t i = 0; i < queries.size(); i++)
+		{
+			t0 = Clock::now();
+			int dist = index.distance(queries[i].first, queries[i].second);
+			double us = std::chrono::duration<double, std::micro>(Clock::now() - t0).count();
+
+			std::string ends = std::to_string(queries[i].first.x) + "," + std::to_string(queries[i].first.y)
+				+ "->" + std::to_string(queries[i].second.x) + "," + std::to_string(queries[i].second.y);
+			if (dist >= 0)
+				std::printf("%-8zu %-20s %10d %12.3f\n", i, ends.c_str(), dist + 1, us);
+			else
+				std::printf("%-8zu %-20s %10s %12.3f\n", i, ends.c_str(), "none", us);
+		}
+
+		return 0;
+	}
+
+	if (agents > 0)
+	{
+		t0 = Clock::now();
+		FlowField field {maze, end};
+		double buildMs = std::chrono::duration<double, std::milli>(Clock::now() - t0).count();
+		std::printf("flow field to %d,%d built in %.3f ms (%zu KB)\n", end.x, end.y, buildMs, field.bytes() / 1024);
+
+		Random random {seed};
+		std::vector<Pos> starts {};
+		for (int i = 0; i < agents; i++)
+			starts.push_back({int(random.below(w)), int(random.below(h))});
+
+		size_t steps = 0, searchSteps = 0;
+		t0 = Clock::now();
+		for (const Pos& s : starts)
+			steps += field.path(s).size();
+		double followMs = std::chrono::duration<double, std::milli>(Clock::now() - t0).count();
+
+		t0 = Clock::now();
+		SearchContext search {maze, {}, {}, BFS};
+		for (const Pos& s : starts)
+		{
+			search.reset(s, end, BFS);
+			searchSteps += search.run().pathLength;
+		}
+		double searchMs = std::chrono::duration<double, std::milli>(Clock::now() - t0).count();
+
+		std::printf("%d agents followed it in %.3f ms (%zu boxes in all), one BFS each takes %.3f ms (%zu boxes)\n",
+			agents, followMs, steps, searchMs, searchSteps);
+		return 0;
+	}
+
+	if (edits > 0)
+	{
+		t0 = Clock::now();
+		DStarLite planner {maze, start, end};
+		SearchResult res = planner.replan();
+		double firstMs = std::chrono::duration<double, std::milli>(Clock::now() - t0).count();
+		std::printf("first plan: path %zu, %zu expanded, %.3f ms\n", res.pathLength, res.expanded, firstMs);
+
+		Random random {seed};
+		size_t changed = 0, replanExpanded = 0, searchExpanded = 0;
+		double replanMs = 0, searchMs = 0;
+		for (int k = 0; k < edits; k++)
+		{
+			// A random box and one of its neighbours
+			Pos box {int(random.below(w)), int(random.below(h))}, next = box;
+			const int dir = int(random.below(4));
+			(dir < 2 ? next.x : next.y) += (dir % 2) ? 1 : -1;
+			if (!maze.open_path(box, next) && !maze.close_path(box, next))
+				continue;
+			changed++;
+
+			t0 = Clock::now();
+			planner.wall_changed(box, next);
+			res = planner.replan();
+			replanMs += std::chrono::duration<double, std::milli>(Clock::now() - t0).count();
+			replanExpanded += res.expanded;
+
+			t0 = Clock::now();
+			SearchResult fresh = solve(maze, start, end, A_STAR, openList, tie);
+			searchMs += std::chrono::duration<double, std::milli>(Clock::now() - t0).count();
+			searchExpanded += fresh.expanded;
+
+			if (fresh.pathLength != res.pathLength)
+				std::fprintf(stderr, "edit %d: D* Lite path %zu, A* path %zu\n", k, res.pathLength, fresh.pathLength);
+		}
+
+		std::printf("%zu edits: repairs took %.3f ms (%zu expanded), A* from scratch %.3f ms (%zu expanded)\n",
+			changed, replanMs, replanExpanded, searchMs, searchExpanded);
+		std::string path = res.found ? std::to_string(res.pathLength) : "none";
+		std::printf("path after the edits: %s\n", path.c_str());
+		return 0;
+	}
+
+	JunctionGraph graph {};
+	if (junctions)
+	{
+		t0 = Clock::now();
+		graph = JunctionGraph {maze};
+		double buildMs = std::chrono::duration<double, std::milli>(Clock::now() - t0).count();
+		std::printf("junction graph built in %.3f ms: %zu of %d boxes left after dead-end filling, "
+			"%zu junctions, %zu edges\n", buildMs, graph.core_size(), w * h, graph.num_junctions(), graph.num_edges());
+	}
+
+	BitGrid grid {};
+	if (bits)
+	{
+		t0 = Clock::now();
+		grid = BitGrid {maze};
+		double buildMs = std::chrono::duration<double, std::milli>(Clock::now() - t0).count();
+		std::printf("bit grid built in %.3f ms (%s, %zu KB)\n", buildMs, BitGrid::simd(), grid.bytes() / 1024);
+	}
+
+	HpaGraph hpa {};
+	if (clusterSize > 0)
+	{
+		t0 = Clock::now();
+		hpa = HpaGraph {maze, clusterSize};
+		double buildMs = std::chrono::duration<double, std::milli>(Clock::now() - t0).count();
+		std::printf("hpa graph built in %.3f ms: %zu entrances, %zu edges (%zu KB)\n",
+			buildMs, hpa.num_nodes(), hpa.num_edges(), hpa.bytes() / 1024);
+	}
+
+	// One search, on whichever structure was asked for
+	auto uncached = [&](Pos from, Pos to, int alg)
+	{
+		if (junctions)
+			return graph.solve(from, to, alg);
+		if (clusterSize > 0 && alg == A_STAR)
+			return hpa.solve(from, to);
+		if (bits && alg == BFS)
+			return grid.solve(from, to);
+		return solve(maze, from, to, alg, openList, tie);
+	};
+	PathCache cache {size_t(std::max(cacheSize, 0))};
+	auto search = [&](Pos from, Pos to, int alg)
+	{
+		SearchResult res {};
+		if (cacheSize <= 0 || !cache.find(maze, from, to, alg, res))
+		{
+			res = uncached(from, to, alg);
+			cache.insert(maze, from, to, alg, res);
+		}
+		return res;
+	};
+
+	if (!queryFile.empty())
+	{
+		std::vector<std::pair<Pos, Pos>> pairs {};
+		if (!read_queries(queryFile, pairs))
+		{
+			std::fprintf(stderr, "%s: can't read %s\n", argv[0], queryFile.c_str());
+			return 1;
+		}
+
+		std::vector<Query> queries {};
+		for (auto& pair : pairs)
+		{
+			for (int alg : algs)
+				queries.push_back({pair.first, pair.second, alg});
+		}
+
+		t0 = Clock::now();
+		std::vector<QueryResult> results {};
+		if (!junctions && !bits && cacheSize <= 0 && clusterSize <= 0)
+			results = solve_batch(maze, queries, threads, openList, tie);
+		else
+		{
+			for (const Query& q : queries)
+			{
+				auto q0 = Clock::now();
+				QueryResult r {};
+				r.result = search(q.start, q.end, q.alg);
+				r.ms = std::chrono::duration<double, std::milli>(Clock::now() - q0).count();
+				results.push_back(r);
+			}
+		}
+		double totalMs = std::chrono::duration<double, std::milli>(Clock::now() - t0).count();
+
+		std::printf("%-8s %-8s %-20s %10s %12s %12s\n", "query", "alg", "endpoints", "path", "expanded", "time_ms");
+		for (size_t i = 0; i < queries.size(); i++)
+		{
+			const Query& q = queries[i];
+			const SearchResult& res = results[i].result;
+			std::string ends = std::to_string(q.start.x) + "," + std::to_string(q.start.y)
+				+ "->" + std::to_string(q.end.x) + "," + std::to_string(q.end.y);
+
+			if (res.found)
+				std::printf("%-8zu %-8s %-20s %10zu %12zu %12.3f\n", i, algorithm_name(q.alg), ends.c_str(),
+					res.pathLength, res.expanded, results[i].ms);
+			else
+				std::printf("%-8zu %-8s %-20s %10s %12zu %12.3f\n", i, algorithm_name(q.alg), ends.c_str(),
+					"none", res.expanded, results[i].ms);
+		}
+		std::printf("%zu queries in %.3f ms (%.0f queries/s)\n",
+			queries.size(), totalMs, queries.size() / (totalMs / 1000.0));
+		if (cacheSize > 0)
+			std::printf("cache: %zu hits, %zu along a kept path, %zu searched\n",
+				cache.num_hits(), cache.num_sub_hits(), cache.num_misses());
+
+		if (!jsonFile.empty())
+		{
+			std::vector<std::pair<int, SearchResult>> runs {};
+			for (size_t i = 0; i < queries.size(); i++)
+				runs.push_back({queries[i].alg, results[i].result});
+			if (!write_runs(jsonFile, runs))
+				std::fprintf(stderr, "%s: can't write %s\n", argv[0], jsonFile.c_str());
+		}
+
+		return 0;
+	}
+
+	std::printf("%-8s %10s %12s %12s %12s %12s %12s\n",
+		"alg", "path", "expanded", "pushed", "peak_front", "peak_kb", "time_ms");
+
+	std::vector<std::pair<int, SearchResult>> runs {};
+	for (int alg : algs)
+	{
+		t0 = Clock::now();
+		SearchResult res {};
+		if (!externalDir.empty())
+		{
+			if (!solve_external(maze, start, end, alg, res, externalDir))
+			{
+				std::fprintf(stderr, "%s: can't make a scratch file in %s\n", argv[0], externalDir.c_str());
+				return 1;
+			}
+		}
+		else
+			res = search(start, end, alg);
+		double ms = std::chrono::duration<double, std::milli>(Clock::now() - t0).count();
+
+		std::string path = res.found ? std::to_string(res.pathLength) : "none";
+		std::printf("%-8s %10s %12zu %12zu %12zu %12zu %12.3f\n", algorithm_name(alg), path.c_str(), res.expanded,
+			res.stats.pushed, res.stats.peakFrontier, res.stats.peakBytes / 1024, ms);
+		runs.push_back({alg, res});
+	}
+
+	if (!jsonFile.empty() && !write_runs(jsonFile, runs))
+	{
+		std::fprintf(stderr, "%s: can't write %s\n", argv[0], jsonFile.c_str());
+		return 1;
+	}
+
+	return 0;
+}